@@ -2,39 +2,51 @@ import json
 import matplotlib.pyplot as plt
 import numpy as np
 
-def plot_mean_latency_with_error(json_file, output_file = "latency_plot.png"):
-    with open(json_file, 'r') as f:
-        data = json.load(f)
+PERCENTILES = ["p50", "p90", "p99", "p99.9", "p99.99"]
 
-    x = []
-    means = []
-    stds = []
-    labels = []
 
-    for category, entries in data.items():
-        if isinstance(entries, list):  # Add / Amend / Cancel
-            for entry in entries:
-                mean = entry["mean_latency"]
-                variance = entry["latency_variance"]
-                std = np.sqrt(variance)
+def get_stat(entry, name):
+    # Stats are written with their unit (e.g. "mean_latency (μs)"), older files don't have it
+    for key in (f"{name} (μs)", name):
+        if key in entry:
+            return entry[key]
+    return None
 
-                means.append(mean)
-                stds.append(std)
 
+def load_latency_entries(json_file):
+    """Return a list of (label, entry) for every latency bucket of the stats file (Add / Amend / Cancel / Match)"""
+    with open(json_file, 'r') as f:
+        data = json.load(f)
+
+    entries = []
+    for category, values in data.items():
+        if isinstance(values, list):  # Add / Amend / Cancel
+            for entry in values:
                 label_parts = [category]
                 if "order_type" in entry:
                     label_parts.append(entry["order_type"])
+                if "amend_path" in entry:
+                    label_parts.append(entry["amend_path"])
                 if "limit_level_status" in entry:
                     label_parts.append(entry["limit_level_status"])
-                labels.append("\n".join(label_parts))
-        else:  # Match
-            mean = entries["mean_latency"]
-            variance = entries["latency_variance"]
-            std = np.sqrt(variance)
+                entries.append(("\n".join(label_parts), entry))
+        elif isinstance(values, dict) and get_stat(values, "mean_latency") is not None:  # Match
+            entries.append((category, values))
+
+    return entries
+
+
+def plot_mean_latency_with_error(json_file, output_file = "latency_plot.png"):
+    entries = load_latency_entries(json_file)
+
+    means = []
+    stds = []
+    labels = []
 
-            means.append(mean)
-            stds.append(std)
-            labels.append("Match")
+    for label, entry in entries:
+        means.append(get_stat(entry, "mean_latency"))
+        stds.append(np.sqrt(get_stat(entry, "latency_variance")))
+        labels.append(label)
 
     x = np.arange(len(means))
 
@@ -55,8 +67,39 @@ def plot_mean_latency_with_error(json_file, output_file = "latency_plot.png"):
     print(f"Latency plot saved")
 
 
+def plot_latency_percentiles(json_file, output_file = "latency_percentiles.png"):
+    # Only stats files with percentiles (written from latency histograms) can be plotted
+    entries = [(label, entry) for label, entry in load_latency_entries(json_file) if get_stat(entry, "p50_latency") is not None]
+    if not entries:
+        print("No percentiles found, skipping the percentiles plot")
+        return
+
+    x = np.arange(len(entries))
+    width = 0.8 / (len(PERCENTILES) + 1)
+
+    plt.figure(figsize=(14, 7))
+    for i, percentile in enumerate(PERCENTILES):
+        values = [get_stat(entry, f"{percentile}_latency") for _, entry in entries]
+        plt.bar(x + i * width, values, width, label=percentile)
+    plt.bar(x + len(PERCENTILES) * width, [get_stat(entry, "max_latency") for _, entry in entries], width, label="max")
+
+    plt.yscale('log')
+    plt.xticks(x + 0.4, [label for label, _ in entries], rotation=45, ha='right')
+    plt.ylabel("Latency (μs, log scale)")
+    plt.title("Latency Percentiles per Order Type")
+    plt.legend()
+    plt.tight_layout()
+    plt.grid(True, which="both", linestyle="--", linewidth=0.5)
+
+    plt.savefig(output_file, dpi=300, bbox_inches='tight')
+    plt.close()
+
+    print(f"Latency percentiles plot saved")
+
+
 
 if __name__ == "__main__":
     json_path = "../orderBook/stats.json"  # Update this path if necessary
     plot_mean_latency_with_error(json_path)
-    print("Plotting complete.")
\ No newline at end of file
+    plot_latency_percentiles(json_path)
+    print("Plotting complete.")
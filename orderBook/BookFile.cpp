@@ -0,0 +1,253 @@
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <vector>
+
+#include "BookFile.h"
+#include "OrderFile.h"
+#include "OrderBook.h"
+
+
+void OrderBook::saveSnapshot(const std::string& filename){
+    /*  The records are staged in a buffer which is checksummed & written once full, thus the file is written in large blocks.
+        The header is written last, with the number of records & the checksum.   */
+    constexpr size_t BUFFER_SIZE = 1 << 20;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        throw std::runtime_error((std::ostringstream{} << "Cannot open file " << filename << " for writing").str());
+
+    BookFileHeader header{};
+    std::memcpy(header.magic, BOOK_FILE_MAGIC, sizeof(BOOK_FILE_MAGIC));
+    header.version = BOOK_FILE_VERSION;
+    header.orderRecordSize = sizeof(BookOrderRecord);
+    header.tickSize = DEFAULT_TICK_SIZE;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    BookFileChecksum checksum;
+    std::vector<char> buffer;
+    buffer.reserve(BUFFER_SIZE);
+
+    auto flush = [&]{
+        checksum.update(buffer.data(), buffer.size());
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+    };
+
+    auto append = [&](const auto& record){
+        if (buffer.size() + sizeof(record) > BUFFER_SIZE)
+            flush();
+        const char* bytes = reinterpret_cast<const char*>(&record);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+    };
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    auto appendLevels = [&](const auto& levels, const std::unordered_map<Price, LimitLevelData>& data, Side side){
+        levels.forEachLevel([&](Price price, const OrderQueue&){
+            const LimitLevelData& level = data.at(price);
+            append(BookLevelRecord{price, level.totalShares, level.totalOrders, side, {}});
+            ++header.nLevels;
+            return true;
+        });
+    };
+
+    auto appendOrders = [&](const auto& levels){
+        levels.forEachLevel([&](Price, const OrderQueue& queue){
+            queue.forEachOrder(pool, [&](const Order& order){
+                append(BookOrderRecord::fromOrder(order));
+                ++header.nOrders;
+                return true;
+            });
+            return true;
+        });
+    };
+
+    appendLevels(bids, bidData, Side::Bid);
+    appendLevels(asks, askData, Side::Ask);
+    appendOrders(bids);
+    appendOrders(asks);
+
+    ordersLock.unlock();
+
+    flush();
+    header.checksum = checksum.value();
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    if (!file)
+        throw std::runtime_error((std::ostringstream{} << "Failed to write the snapshot to " << filename).str());
+}
+
+
+size_t OrderBook::loadSnapshot(const std::string& filename){
+    /*  The file is validated (header, size, checksum) before the book is touched. The levels & orders are then rebuilt
+        in the order of the file, i.e. in time priority within each level, each order being copied once into the pool.
+        If a record is inconsistent (e.g. a level's totals don't match its orders, levels out of order or crossing) the book is
+        emptied again. Subscribers to the market data receive one Add per level once the book is loaded.
+        Returns the number of GFD & GTT orders whose expiry has already passed (a snapshot restored after the close): they are
+        loaded, and expired by the next expireOrders call.   */
+    MappedFile file(filename);
+
+    if (file.size() < sizeof(BookFileHeader))
+        throw std::runtime_error((std::ostringstream{} << filename << " is too small to be a book snapshot").str());
+
+    const BookFileHeader& header = *reinterpret_cast<const BookFileHeader*>(file.data());
+
+    if (std::memcmp(header.magic, BOOK_FILE_MAGIC, sizeof(BOOK_FILE_MAGIC)) != 0)
+        throw std::runtime_error((std::ostringstream{} << filename << " is not a book snapshot").str());
+
+    if (header.version != BOOK_FILE_VERSION || header.orderRecordSize != sizeof(BookOrderRecord))
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " has an unsupported version (" << header.version << ") or record size (" << header.orderRecordSize << ")").str()
+        );
+
+    if (std::abs(header.tickSize - DEFAULT_TICK_SIZE) > 1e-12)
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " has a tick size of " << header.tickSize << " instead of " << DEFAULT_TICK_SIZE).str()
+        );
+
+    const size_t bodySize = file.size() - sizeof(BookFileHeader);
+    if (header.nLevels > bodySize / sizeof(BookLevelRecord) || header.nOrders > bodySize / sizeof(BookOrderRecord)
+            || header.nLevels * sizeof(BookLevelRecord) + header.nOrders * sizeof(BookOrderRecord) != bodySize)
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " doesn't hold " << header.nLevels << " levels & " << header.nOrders << " orders").str()
+        );
+
+    BookFileChecksum checksum;
+    checksum.update(file.data() + sizeof(BookFileHeader), bodySize);
+    if (checksum.value() != header.checksum)
+        throw std::runtime_error((std::ostringstream{} << filename << " is corrupted (checksum mismatch)").str());
+
+    const BookLevelRecord* levelRecords = reinterpret_cast<const BookLevelRecord*>(file.data() + sizeof(BookFileHeader));
+    const BookOrderRecord* orderRecords = reinterpret_cast<const BookOrderRecord*>(levelRecords + header.nLevels);
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    if (!orders.empty())
+        throw std::logic_error("A snapshot can only be loaded into an empty order book");
+
+    auto invalid = [&](const std::string& reason){
+        return std::runtime_error((std::ostringstream{} << filename << " is inconsistent: " << reason).str());
+    };
+
+    auto clear = [&]{
+        /* The book was empty: every structure is reset, including the expiry entries of orders cancelled before the load */
+        bids = PriceLevels<Side::Bid>();
+        asks = PriceLevels<Side::Ask>();
+        bidData.clear();
+        askData.clear();
+        bidDepth = CumulativeDepth();
+        askDepth = CumulativeDepth();
+        orders = OrderIdMap<OrderInfo>();
+        pool.clear();
+        dayOrders.clear();
+        timedOrders = TimerWheel<OrderId>(toExpiryTime(clock.now()));
+        expiredOrders.clear();
+    };
+
+    constexpr size_t PREFETCH_DISTANCE = 16;    // Orders ahead whose slot of the orders map is prefetched (random accesses)
+
+    const ExpiryTime now = toExpiryTime(clock.now());
+    size_t nExpired = 0;
+
+    try{
+        orders.reserve(header.nOrders);
+        pool.reserve(header.nOrders);
+
+        size_t nextOrder = 0;
+        const BookLevelRecord* previousLevel = nullptr;
+        Price bestBidPrice = 0;     // 0: no bid level
+
+        for (size_t i = 0; i < header.nLevels; ++i){
+            const BookLevelRecord& level = levelRecords[i];
+            auto& data = (level.side == Side::Bid) ? bidData : askData;
+            auto& depth = (level.side == Side::Bid) ? bidDepth : askDepth;
+
+            if ((level.side != Side::Bid && level.side != Side::Ask) || level.price <= 0)
+                throw invalid((std::ostringstream{} << "level " << i << " has an invalid side or price").str());
+
+            // Bids then asks, best price first, and the first ask above the best bid (a crossed book would never match)
+            if (previousLevel != nullptr && previousLevel->side == level.side){
+                if ((level.side == Side::Bid) ? level.price >= previousLevel->price : level.price <= previousLevel->price)
+                    throw invalid((std::ostringstream{} << "level " << i << " isn't in best price first order").str());
+            }
+            else if (level.side == Side::Bid){
+                if (previousLevel != nullptr)
+                    throw invalid((std::ostringstream{} << "level " << i << " is a bid after the asks").str());
+                bestBidPrice = level.price;
+            }
+            else if (bestBidPrice != 0 && level.price <= bestBidPrice)
+                throw invalid((std::ostringstream{} << "the best ask (level " << i << ") doesn't lie above the best bid").str());
+            previousLevel = &level;
+
+            if (level.totalOrders == 0 || level.totalOrders > header.nOrders - nextOrder || data.count(level.price) != 0)
+                throw invalid((std::ostringstream{} << "level " << i << " is empty, a duplicate or has too many orders").str());
+
+            OrderQueue& queue = (level.side == Side::Bid) ? bids[level.price] : asks[level.price];
+            uint64_t totalShares = 0;
+
+            for (uint32_t k = 0; k < level.totalOrders; ++k){
+                if (nextOrder + PREFETCH_DISTANCE < header.nOrders)
+                    orders.prefetch(orderRecords[nextOrder + PREFETCH_DISTANCE].orderId);
+
+                const BookOrderRecord& record = orderRecords[nextOrder++];
+
+                if (record.side != level.side || record.price != level.price)
+                    throw invalid((std::ostringstream{} << "order " << record.orderId << " doesn't belong to its level").str());
+
+                // Only GTC, GFD & GTT orders rest: market, FAK & FOK orders never stay in the book
+                const bool rests = record.type == Type::GTC || record.type == Type::GFD || record.type == Type::GTT;
+                if (record.shares == 0 || record.shares > record.initialShares || !rests)
+                    throw invalid((std::ostringstream{} << "order " << record.orderId << " has an invalid type or number of shares").str());
+
+                const PoolIndex orderIndex = pool.allocate(record.toOrder());
+                if (!orders.insert(record.orderId, OrderInfo{orderIndex})){
+                    pool.release(orderIndex);
+                    throw invalid((std::ostringstream{} << "order ID " << record.orderId << " is duplicated").str());
+                }
+                queue.pushBack(pool, orderIndex);
+                totalShares += record.shares;
+
+                // Saved expiries are kept as is, thus a GFD order still expires at the close of the day it was placed
+                if ((record.type == Type::GFD || record.type == Type::GTT) && record.expiry == 0)
+                    throw invalid((std::ostringstream{} << "order " << record.orderId << " has no expiry").str());
+                nExpired += (record.type == Type::GFD || record.type == Type::GTT) && record.expiry <= now;
+
+                if (record.type == Type::GFD)
+                    dayOrders[record.expiry].push_back(record.orderId);
+                else if (record.type == Type::GTT)
+                    timedOrders.schedule(record.expiry, record.orderId);
+            }
+
+            if (totalShares != level.totalShares)
+                throw invalid((std::ostringstream{} << "the shares of level " << i << " don't add up").str());
+
+            depth.cover(level.price, data);
+            data[level.price] = LimitLevelData{level.totalShares, level.totalOrders};
+            depth.add(level.price, level.totalShares);
+        }
+
+        if (nextOrder != header.nOrders)
+            throw invalid((std::ostringstream{} << (header.nOrders - nextOrder) << " orders don't belong to any level").str());
+    }
+    catch (...){
+        clear();
+        throw;
+    }
+
+    for (size_t i = 0; i < header.nLevels; ++i){
+        const BookLevelRecord& level = levelRecords[i];
+        marketData.publish(level.side, level.price, level.totalShares, level.totalOrders, LevelAction::Add);
+    }
+
+    bidView.invalidate();
+    askView.invalidate();
+    viewChanged = true;
+    publishView();
+    return nExpired;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+#include "WallClock.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+/*  Binary snapshot of the full state of an order book (OrderBook::saveSnapshot / loadSnapshot), little endian:
+        - a 48-byte header, with a checksum of everything that follows it
+        - one 16-byte record per limit level (its totals), bids then asks, best price first
+        - one 32-byte record per resting order, level after level in the same order, and in time priority within a level
+    Loading rebuilds the levels, the pool and the orders map directly from the records: nothing is matched, logged nor timed,
+    and the orders keep their time priority. The file is memory mapped (see MappedFile in OrderFile.h), thus the code
+    using snapshots also compiles OrderFile.cpp & BookFile.cpp (see snapshot_benchmark.cpp).
+    The book is locked while it is saved, thus the snapshot is consistent.   */
+
+constexpr char BOOK_FILE_MAGIC[8] = {'O', 'B', 'S', 'N', 'A', 'P', 'S', 'H'};
+constexpr uint32_t BOOK_FILE_VERSION = 1;
+
+struct BookFileHeader{
+    char magic[8];          // BOOK_FILE_MAGIC
+    uint32_t version;       // BOOK_FILE_VERSION
+    uint32_t orderRecordSize;   // sizeof(BookOrderRecord)
+    uint64_t nLevels;
+    uint64_t nOrders;
+    double tickSize;        // Prices are stored in ticks of tickSize
+    uint64_t checksum;      // bookFileChecksum of the level & order records
+};
+
+struct BookLevelRecord{
+    Price price;
+    uint32_t totalShares;
+    uint32_t totalOrders;
+    Side side;
+    uint8_t padding[3];
+};
+
+struct BookOrderRecord{
+    OrderId orderId;
+    Price price;
+    Quantity initialShares;
+    Quantity shares;
+    ExpiryTime expiry;
+    SymbolId symbol;
+    Type type;
+    Side side;
+    uint64_t reserved;
+
+    static BookOrderRecord fromOrder(const Order& order){
+        return BookOrderRecord{order.getOrderId(), order.getOrderPrice(), order.getOrderInitialShares(), order.getOrderShares(),
+                                order.getOrderExpiry(), order.getOrderSymbol(), order.getOrderType(), order.getOrderSide(), 0};
+    }
+
+    Order toOrder() const{
+        /* The order as it was saved, partial fills included (may throw std::invalid_argument, see the Order constructor) */
+        Order order(orderId, type, side, price, shares, symbol);
+        order.init_shares = initialShares;
+        order.expiry = expiry;
+        return order;
+    }
+};
+
+static_assert(sizeof(BookFileHeader) == 48, "The book file header layout must not depend on the compiler");
+static_assert(sizeof(BookLevelRecord) == 16, "The book level record layout must not depend on the compiler");
+static_assert(sizeof(BookOrderRecord) == 32, "The book order record layout must not depend on the compiler");
+
+
+// Checksum of the records, 8 bytes at a time (a few GB/s, thus negligible next to reading the file)
+class BookFileChecksum{
+private:
+    static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+    static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+    uint64_t state = 0x27D4EB2F165667C5ull;
+
+public:
+    void update(const void* data, size_t size){
+        /* size must be a multiple of 8 bytes, which is the case of whole records */
+        const char* bytes = static_cast<const char*>(data);
+        for (size_t offset = 0; offset < size; offset += sizeof(uint64_t)){
+            uint64_t word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            state ^= word * PRIME_2;
+            state = ((state << 31) | (state >> 33)) * PRIME_1;
+        }
+    }
+
+    uint64_t value() const{
+        uint64_t hash = state;
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        return hash;
+    }
+};
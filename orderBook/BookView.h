@@ -0,0 +1,186 @@
+#pragma once
+
+#include "enums.h"
+#include "LimitLevel.h"
+#include "MarketData.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+
+/*  Read-side view of an order book for reader threads that poll it (strategies reading the top of book & depth): the book
+    publishes the top BOOK_VIEW_LEVELS levels of each side, its last trade and its L2 sequence number after each command that
+    changed them (OrderBook::attachView), through a seqlock. The levels are maintained in place as the book changes (see
+    BookViewSide), thus a publication copies a few hundred bytes without walking the book. Readers never take the book's lock
+    nor write to shared memory: any number of them get consistent snapshots without slowing the matching thread.   */
+
+constexpr size_t BOOK_VIEW_LEVELS = 10;
+
+struct LastTrade{
+    Price price = 0;            // Price of the resting order
+    Quantity shares = 0;
+    Side aggressor = Side::Bid;
+};
+
+struct BookViewSnapshot{
+    uint64_t sequence = 0;      // L2 sequence number of the book (see MarketData.h) when the snapshot was published. Changes deeper
+                                // than the view aren't published, thus the book may be further along with the same view
+    uint64_t nTrades = 0;       // Executions since the book was created
+    LastTrade lastTrade;        // Valid if nTrades > 0
+    uint32_t nBids = 0;         // Levels used in bids & asks
+    uint32_t nAsks = 0;
+    LimitLevelInfo bids[BOOK_VIEW_LEVELS];  // Best (highest) price first
+    LimitLevelInfo asks[BOOK_VIEW_LEVELS];  // Best (lowest) price first
+
+    // An empty side gives a level of price 0 with no shares, as OrderBook::getBestBid & getBestAsk
+    LimitLevelInfo bestBid() const {return (nBids == 0) ? LimitLevelInfo{0, 0, 0} : bids[0];}
+    LimitLevelInfo bestAsk() const {return (nAsks == 0) ? LimitLevelInfo{0, 0, 0} : asks[0];}
+    Price spread() const {return (nBids == 0 || nAsks == 0) ? 0 : asks[0].price - bids[0].price;}
+};
+
+static_assert(std::is_trivially_copyable<BookViewSnapshot>::value, "Snapshots are copied word by word");
+static_assert(sizeof(BookViewSnapshot) % sizeof(uint64_t) == 0, "Snapshots are copied word by word");
+
+
+/*  Seqlock: the version is odd while the writer copies a snapshot in. A reader copies the snapshot out between two reads of
+    the version and retries if they differ or are odd. The words are relaxed atomics (plain moves on x86-64 & ARM), thus a
+    read torn by a concurrent write is detected and discarded, never a data race. Single writer: the book, under its lock.   */
+class BookView{
+private:
+    static constexpr size_t N_WORDS = sizeof(BookViewSnapshot) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint64_t> version{0};
+    alignas(64) std::atomic<uint64_t> words[N_WORDS];   // On their own cache lines, thus the version's line only moves on writes
+
+public:
+    BookView() {publish(BookViewSnapshot{});}
+
+    BookView(const BookView&) = delete;
+    BookView& operator=(const BookView&) = delete;
+
+    void publish(const BookViewSnapshot& snapshot){
+        const char* source = reinterpret_cast<const char*>(&snapshot);
+
+        const uint64_t start = version.load(std::memory_order_relaxed);
+        version.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);    // The odd version is visible before any word changes
+
+        for (size_t i = 0; i < N_WORDS; ++i){
+            uint64_t word;
+            std::memcpy(&word, source + i * sizeof(word), sizeof(word));
+            words[i].store(word, std::memory_order_relaxed);
+        }
+
+        version.store(start + 2, std::memory_order_release);
+    }
+
+    bool tryRead(BookViewSnapshot& snapshot) const{
+        /* Returns false if a publication overlapped the copy (snapshot is then garbage) */
+        uint64_t copy[N_WORDS];
+
+        const uint64_t start = version.load(std::memory_order_acquire);
+        if (start & 1)
+            return false;
+
+        for (size_t i = 0; i < N_WORDS; ++i)
+            copy[i] = words[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);    // The words are read before the version is checked again
+        if (version.load(std::memory_order_relaxed) != start)
+            return false;
+
+        std::memcpy(&snapshot, copy, sizeof(snapshot));
+        return true;
+    }
+
+    BookViewSnapshot read() const{
+        /* Retries until a copy doesn't overlap a publication, which is a few hundred bytes long */
+        BookViewSnapshot snapshot;
+        while (!tryRead(snapshot));
+        return snapshot;
+    }
+
+    uint64_t getVersion() const {return version.load(std::memory_order_acquire) / 2;}   // Number of publications
+};
+
+
+/*  Best levels of one side kept by the writer from the level updates of the book, up to twice BOOK_VIEW_LEVELS: a level
+    leaving the view is replaced by the next kept one, and the side only has to be collected again from the book (isStale)
+    once less than BOOK_VIEW_LEVELS levels are kept while the book has more.   */
+template<Side S>
+class BookViewSide{
+private:
+    static constexpr uint32_t CAPACITY = 2 * BOOK_VIEW_LEVELS;
+
+    LimitLevelInfo levels[CAPACITY];    // Best price first
+    uint32_t nLevels = 0;
+    bool truncated = true;  // The book may have levels beyond the kept ones (initially: nothing is known)
+
+    static bool isBetter(Price price, Price otherPrice) {return (S == Side::Bid) ? price > otherPrice : price < otherPrice;}
+
+public:
+    bool isStale() const {return truncated && nLevels < BOOK_VIEW_LEVELS;}
+
+    void invalidate(){
+        nLevels = 0;
+        truncated = true;
+    }
+
+    template<typename ForEachLevel>
+    void collect(ForEachLevel&& forEachLevel){
+        /* forEachLevel(function) calls function(level) from the best level of the book until it returns false */
+        nLevels = 0;
+        forEachLevel([this](const LimitLevelInfo& level){
+            levels[nLevels++] = level;
+            return nLevels < CAPACITY;
+        });
+        truncated = nLevels == CAPACITY;
+    }
+
+    bool apply(Price price, uint32_t totalShares, uint32_t totalOrders, LevelAction action){
+        /* Returns whether the levels in the view changed */
+        uint32_t i = 0;     // Position of price: first level that isn't better
+        while (i < nLevels && isBetter(levels[i].price, price))
+            ++i;
+        const bool kept = i < nLevels && levels[i].price == price;
+
+        switch (action){
+            case LevelAction::Add:
+                if (i == nLevels && (truncated || nLevels == CAPACITY)){
+                    truncated = true;   // Beyond the kept levels
+                    return false;
+                }
+                if (nLevels == CAPACITY){
+                    truncated = true;   // The worst kept level is dropped
+                    --nLevels;
+                }
+                std::copy_backward(levels + i, levels + nLevels, levels + nLevels + 1);
+                levels[i] = LimitLevelInfo{price, totalShares, totalOrders};
+                ++nLevels;
+                break;
+            case LevelAction::Update:
+                if (!kept)
+                    return false;
+                levels[i] = LimitLevelInfo{price, totalShares, totalOrders};
+                break;
+            case LevelAction::Delete:
+                if (!kept)
+                    return false;
+                std::copy(levels + i + 1, levels + nLevels, levels + i);
+                --nLevels;
+                break;
+        }
+
+        return i < BOOK_VIEW_LEVELS;
+    }
+
+    uint32_t copyView(LimitLevelInfo* view) const{
+        /* The best BOOK_VIEW_LEVELS levels (or less) into view, returns their number */
+        const uint32_t nView = std::min<uint32_t>(nLevels, BOOK_VIEW_LEVELS);
+        std::copy(levels, levels + nView, view);
+        return nView;
+    }
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "enums.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+/*  Cumulative shares of one side of the book over price ticks, stored in a Fenwick (binary indexed) tree, thus both updating
+    the shares of a level and asking "how many shares rest at or below / at or above price P" take O(log ticks).
+    The tree covers a window of ticks [basePrice, basePrice + capacity), which is moved & grown (rebuilt from the levels)
+    when a level appears outside of it. A window larger than MAX_CAPACITY ticks (outlier prices) disables the index:
+    the owner then falls back to walking the levels (see isEnabled). Once a level at one of the extreme prices is removed
+    (levelRemoved), the span may fit again: the next cover tries to rebuild the index, at most once per levels.size()
+    updates, thus the scans stay amortized O(1) while an outlier level remains.   */
+class CumulativeDepth{
+private:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 12;
+    static constexpr size_t MAX_CAPACITY = 1 << 22;    // 32 MB of counters
+
+    std::vector<uint64_t> tree; // 1-based Fenwick tree: tree[i] holds the shares of the ticks (i - lowbit(i), i]
+    Price basePrice = 0;        // Price of the first tick of the window
+    uint64_t totalShares = 0;
+    bool enabled = true;
+
+    // While disabled: bounds of the prices covered since the last rebuild attempt, whether a level at one of them was
+    // removed since, and the number of updates since the last attempt
+    Price lowPrice = 0, highPrice = 0;
+    bool mayFit = false;
+    size_t updatesSinceRebuild = 0;
+
+    size_t capacity() const {return tree.size() - 1;}
+
+    bool inWindow(Price price) const {return price >= basePrice && price < basePrice + static_cast<Price>(capacity());}
+
+    uint64_t prefixSum(size_t position) const{
+        /* Shares of the first position ticks of the window */
+        uint64_t sum = 0;
+        for (; position > 0; position &= position - 1)
+            sum += tree[position];
+        return sum;
+    }
+
+    template<typename Levels>
+    void rebuild(Price price, const Levels& levels){
+        /* Window covering price and the levels, or the index disabled if it would be larger than MAX_CAPACITY ticks */
+        Price low = price, high = price;
+        for (const auto& level : levels){
+            low = std::min(low, level.first);
+            high = std::max(high, level.first);
+        }
+
+        const size_t span = static_cast<size_t>(static_cast<int64_t>(high) - low) + 1;
+        size_t newCapacity = enabled ? capacity() : DEFAULT_CAPACITY;
+        while (span > newCapacity / 2 && newCapacity <= MAX_CAPACITY)   // Keep some room on both sides to avoid moving again soon
+            newCapacity *= 2;
+
+        if (newCapacity > MAX_CAPACITY){
+            enabled = false;
+            tree = std::vector<uint64_t>();
+            lowPrice = low;
+            highPrice = high;
+            mayFit = false;
+            updatesSinceRebuild = 0;
+            return;
+        }
+
+        enabled = true;
+        basePrice = low - static_cast<Price>((newCapacity - span) / 2);
+        tree.assign(newCapacity + 1, 0);
+        totalShares = 0;
+
+        // Linear construction: point values first, then each node is pushed to its parent
+        for (const auto& level : levels){
+            tree[level.first - basePrice + 1] += level.second.totalShares;
+            totalShares += level.second.totalShares;
+        }
+        for (size_t i = 1; i <= newCapacity; ++i){
+            const size_t parent = i + (i & (~i + 1));
+            if (parent <= newCapacity)
+                tree[parent] += tree[i];
+        }
+    }
+
+public:
+    CumulativeDepth(): tree(DEFAULT_CAPACITY + 1, 0) {}
+
+    bool isEnabled() const {return enabled;}
+
+    template<typename Levels>
+    void cover(Price price, const Levels& levels){
+        /*  Make sure price is in the window, before a level of this price is updated.
+            levels: the price -> level data map (with totalShares) of the side, used to rebuild the tree if the window moves   */
+        if (enabled){
+            if (!inWindow(price))
+                rebuild(price, levels);
+            return;
+        }
+
+        lowPrice = std::min(lowPrice, price);
+        highPrice = std::max(highPrice, price);
+        if (++updatesSinceRebuild >= levels.size() && mayFit)
+            rebuild(price, levels);
+    }
+
+    void levelRemoved(Price price){
+        /* Called once the level of this price is removed from the side: while disabled, the span may fit again */
+        if (!enabled && (price == lowPrice || price == highPrice))
+            mayFit = true;
+    }
+
+    void add(Price price, int64_t shares){
+        /* Add (or remove if negative) shares to the level of the given price, which must be covered (see cover) */
+        if (!enabled)
+            return;
+
+        totalShares += shares;
+        for (size_t position = price - basePrice + 1; position <= capacity(); position += position & (~position + 1))
+            tree[position] += shares;   // Unsigned wrap-around makes negative additions exact
+    }
+
+    uint64_t sharesAtOrBelow(Price price) const{
+        if (price < basePrice)
+            return 0;
+        if (price >= basePrice + static_cast<Price>(capacity()))
+            return totalShares;
+        return prefixSum(price - basePrice + 1);
+    }
+
+    uint64_t sharesAtOrAbove(Price price) const {return totalShares - sharesAtOrBelow(price - 1);}
+
+    uint64_t getTotalShares() const {return totalShares;}
+};
@@ -0,0 +1,120 @@
+#include "EventLog.h"
+
+#include <chrono>
+
+
+EventLog::EventLog(LogVerbosity _verbosity, std::ostream& _output, size_t capacity)
+: verbosity(_verbosity), ring(_verbosity == LogVerbosity::Silent ? 2 : capacity), output(_output)
+{
+    if (verbosity != LogVerbosity::Silent)
+        writerThread = std::thread([this] {
+                                                writeRecords();
+                                            }
+                                    );
+}
+
+EventLog::~EventLog(){
+    // The writer thread drains the remaining records before exiting
+    stopping.store(true, std::memory_order_release);
+
+    if (writerThread.joinable())
+        writerThread.join();
+
+    if (getNumberOfDroppedRecords() > 0)
+        std::cerr << "Warning: " << getNumberOfDroppedRecords() << " log records were dropped as the log ring buffer was full." << std::endl;
+}
+
+
+void EventLog::writeRecords(){
+    /* Background thread: format the records as they arrive, and flush the output whenever the ring buffer is empty */
+    LogRecord logRecord;
+    uint64_t written = 0;
+
+    while (true){
+        if (ring.tryPop(logRecord)){
+            format(output, logRecord);
+            ++written;
+            continue;
+        }
+
+        if (written != nWritten.load(std::memory_order_relaxed)){
+            output.flush();
+            nWritten.store(written, std::memory_order_release);
+        }
+
+        if (stopping.load(std::memory_order_acquire) && ring.empty())
+            return;
+
+        std::this_thread::sleep_for(std::chrono::microseconds(50));    // This thread isn't on the critical path
+    }
+}
+
+
+void EventLog::flush() const{
+    if (verbosity == LogVerbosity::Silent)
+        return;
+
+    const uint64_t recorded = nRecorded.load(std::memory_order_acquire);
+    while (nWritten.load(std::memory_order_acquire) < recorded)
+        std::this_thread::yield();
+}
+
+
+void EventLog::format(std::ostream& stream, const LogRecord& logRecord){
+    switch (logRecord.event){
+        case EventType::AddOrder:
+            stream << "Adding Order: ID " << logRecord.orderId
+                    << ", Side " << toString(logRecord.side)
+                    << " & Type " << toString(logRecord.type)
+                    << ", Price = " << toDecimalPrice(logRecord.price)
+                    << ", Shares = " << logRecord.shares << '\n';
+            break;
+
+        case EventType::ModifyOrder:
+            stream << "Modifying Order of ID " << logRecord.orderId
+                    << ", Side " << toString(logRecord.side)
+                    << " & Type " << toString(logRecord.type)
+                    << ": Price = " << toDecimalPrice(logRecord.price)
+                    << ", Shares = " << logRecord.shares << '\n';
+            break;
+
+        case EventType::RestOrder:
+            stream << "Order added to " << toString(logRecord.side) << "s at price " << toDecimalPrice(logRecord.price) << '\n';
+            break;
+
+        case EventType::Trade:
+            stream << "  Trade: Bid ID = " << logRecord.orderId << ", Ask ID = " << logRecord.otherOrderId
+                    << ", Shares = " << logRecord.shares << '\n';
+            break;
+
+        case EventType::ExpireOrder:
+            stream << "Order of ID " << logRecord.orderId << " expired (Type " << toString(logRecord.type) << ")" << '\n';
+            break;
+
+        case EventType::Reject:
+            switch (logRecord.reason){
+                case RejectReason::DuplicateId:
+                    stream << "Order ID " << logRecord.orderId << " already exists. Skipping." << '\n';
+                    break;
+                case RejectReason::FAKCannotMatch:
+                    stream << "FAK order cannot be matched. Skipping." << '\n';
+                    break;
+                case RejectReason::FOKCannotFill:
+                    stream << "FOK order cannot be fully filled. Skipping." << '\n';
+                    break;
+                case RejectReason::MarketCannotFill:
+                    stream << "Market order cannot be processed. Skipping." << '\n';
+                    break;
+                case RejectReason::InvalidSide:
+                    stream << "Invalid order side. Skipping order." << '\n';
+                    break;
+                case RejectReason::UnknownOrder:
+                    stream << "Inexistent order. Can't be modified." << '\n';
+                    break;
+                case RejectReason::Expired:
+                    stream << "GTT order already expired. Skipping." << '\n';
+                    break;
+            }
+            break;
+    }
+}
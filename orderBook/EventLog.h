@@ -0,0 +1,86 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+#include "SpscQueue.h"
+
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <iostream>
+
+enum class LogVerbosity {Silent = 0, Trades, Orders};  // Silent: nothing is logged; Trades: trades only; Orders: orders, rejections & trades
+
+enum class EventType : uint8_t {AddOrder = 0, ModifyOrder, RestOrder, Trade, Reject, ExpireOrder};
+
+enum class RejectReason : uint8_t {DuplicateId = 0, FAKCannotMatch, FOKCannotFill, MarketCannotFill, InvalidSide, UnknownOrder, Expired};
+
+struct LogRecord{   // Fixed-size binary record written by the matching thread, formatted later by the writer thread
+    EventType event;
+    Type type;
+    Side side;
+    RejectReason reason;
+    uint32_t orderId;
+    uint32_t otherOrderId;  // Ask order ID for trades
+    Price price;
+    uint32_t shares;
+};  // 20 bytes
+
+/*  Asynchronous event log: the matching path only copies fixed-size records into a lock-free ring buffer,
+    and a background thread formats and writes them, thus there is no formatting, flush nor syscall on the hot path.
+    The ring buffer has a single producer: callers must be serialized (OrderBook logs while holding its lock).
+    When the ring buffer is full the record is dropped and counted rather than blocking the matching thread.
+    In Silent mode nothing is recorded and no background thread is started.   */
+class EventLog{
+private:
+    LogVerbosity verbosity;
+    SpscQueue<LogRecord> ring;
+    std::ostream& output;
+
+    std::thread writerThread;
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> nDropped{0};
+    std::atomic<uint64_t> nRecorded{0};     // Number of records pushed into the ring buffer
+    std::atomic<uint64_t> nWritten{0};      // Number of records formatted and flushed to the output
+
+    void record(const LogRecord& logRecord){
+        if (ring.tryPush(logRecord))
+            nRecorded.store(nRecorded.load(std::memory_order_relaxed) + 1, std::memory_order_release);  // Single producer
+        else
+            nDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void writeRecords();
+
+    static void format(std::ostream& stream, const LogRecord& logRecord);
+
+public:
+    EventLog(LogVerbosity _verbosity = LogVerbosity::Orders, std::ostream& _output = std::cout, size_t capacity = 1 << 16);
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    LogVerbosity getVerbosity() const {return verbosity;}
+    bool enabled(LogVerbosity level) const {return verbosity >= level;}
+    uint64_t getNumberOfDroppedRecords() const {return nDropped.load(std::memory_order_relaxed);}
+
+    // Recording methods, called from the matching path
+    void logOrder(EventType event, const Order& order){
+        if (enabled(LogVerbosity::Orders))
+            record(LogRecord{event, order.getOrderType(), order.getOrderSide(), RejectReason::DuplicateId,
+                                order.getOrderId(), 0, order.getOrderPrice(), order.getOrderShares()});
+    }
+
+    void logReject(uint32_t orderId, RejectReason reason){
+        if (enabled(LogVerbosity::Orders))
+            record(LogRecord{EventType::Reject, Type::GTC, Side::Bid, reason, orderId, 0, 0, 0});
+    }
+
+    void logTrade(uint32_t bidOrderId, uint32_t askOrderId, uint32_t shares){
+        if (enabled(LogVerbosity::Trades))
+            record(LogRecord{EventType::Trade, Type::GTC, Side::Bid, RejectReason::DuplicateId, bidOrderId, askOrderId, 0, shares});
+    }
+
+    void flush() const; // Wait until every recorded event has been written
+};
@@ -0,0 +1,163 @@
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+
+#include "Exchange.h"
+
+
+Exchange::Exchange(size_t nSymbols, size_t nWorkers, size_t queueCapacity, size_t expectedOrdersPerBook, LogVerbosity verbosity){
+    if (nSymbols == 0 || nSymbols > size_t(UINT16_MAX) + 1)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "The number of symbols (" << nSymbols << ") should be between 1 and " << size_t(UINT16_MAX) + 1).str()
+        );
+
+    if (nWorkers == 0)
+        nWorkers = std::max(1u, std::thread::hardware_concurrency());
+    nWorkers = std::min(nWorkers, nSymbols);
+
+    // GFD & GTT orders are expired by the workers, thus the books don't start their own prune thread
+    books.reserve(nSymbols);
+    for (size_t symbol = 0; symbol < nSymbols; ++symbol)
+        books.push_back(std::make_unique<OrderBook>(expectedOrdersPerBook, verbosity, false));
+
+    workers.reserve(nWorkers);
+    for (size_t w = 0; w < nWorkers; ++w)
+        workers.push_back(std::make_unique<Worker>(queueCapacity));
+
+    for (size_t symbol = 0; symbol < nSymbols; ++symbol)
+        getWorker(static_cast<SymbolId>(symbol)).symbols.push_back(static_cast<SymbolId>(symbol));
+
+    for (auto& worker : workers){
+        Worker* workerPtr = worker.get();
+        worker->thread = std::thread([this, workerPtr] {
+                                                            run(*workerPtr);
+                                                        }
+                                    );
+    }
+}
+
+Exchange::~Exchange(){
+    // Workers exit once their ring buffer is empty
+    stopping.store(true, std::memory_order_release);
+
+    for (auto& worker : workers)
+        if (worker->thread.joinable())
+            worker->thread.join();
+}
+
+
+void Exchange::run(Worker& worker){
+    /* Worker thread: process the commands of its symbols as they arrive, and expire their GFD & GTT orders while idle */
+    constexpr uint32_t IDLE_SPINS = 64;     // Number of empty polls before yielding the CPU
+
+    OrderCommand command;
+    uint32_t idleSpins = 0;
+
+    while (true){
+        if (worker.inbound.tryPop(command)){
+            execute(worker, command);
+            worker.nProcessed.store(worker.nProcessed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            idleSpins = 0;
+            continue;
+        }
+
+        if (stopping.load(std::memory_order_acquire) && worker.inbound.empty())
+            return;
+
+        if (++idleSpins < IDLE_SPINS)
+            continue;
+        idleSpins = 0;
+
+        // One chunk per book, thus the commands that arrive meanwhile wait for at most one chunk per symbol
+        for (SymbolId symbol : worker.symbols)
+            books[symbol]->expireOrders();
+
+        std::this_thread::yield();
+    }
+}
+
+
+void Exchange::execute(Worker& worker, const OrderCommand& command){
+    OrderBook& book = *books[command.symbol];
+    TradeCounter tradeCounter;
+
+    try{
+        switch (command.command){
+            case CommandType::Add:
+                book.addOrder(command.toOrder(), tradeCounter);
+                break;
+            case CommandType::Cancel:
+                book.cancelOrder(command.orderId);
+                break;
+            case CommandType::Amend:
+                book.amendOrder(command.orderId, command.price, command.shares, tradeCounter);
+                break;
+        }
+    }
+    catch (const std::exception&){
+        worker.nRejected.store(worker.nRejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    if (tradeCounter.nTrades != 0)
+        worker.nTrades.store(worker.nTrades.load(std::memory_order_relaxed) + tradeCounter.nTrades, std::memory_order_relaxed);
+}
+
+
+bool Exchange::trySubmit(const OrderCommand& command){
+    if (command.symbol >= books.size())
+        throw std::out_of_range(
+            (std::ostringstream{} << "Order (" << command.orderId << ") has an unknown symbol (" << command.symbol << ")").str()
+        );
+
+    Worker& worker = getWorker(command.symbol);
+    if (!worker.inbound.tryPush(command))
+        return false;
+
+    ++worker.nSubmitted;
+    return true;
+}
+
+
+void Exchange::submit(const OrderCommand& command){
+    while (!trySubmit(command))
+        std::this_thread::yield();  // The worker is behind, let it catch up
+}
+
+
+void Exchange::drain(){
+    for (auto& worker : workers)
+        while (worker->nProcessed.load(std::memory_order_acquire) < worker->nSubmitted)
+            std::this_thread::yield();
+}
+
+
+uint64_t Exchange::getNumberOfProcessedCommands() const{
+    uint64_t total = 0;
+    for (const auto& worker : workers)
+        total += worker->nProcessed.load(std::memory_order_acquire);
+    return total;
+}
+
+
+uint64_t Exchange::getNumberOfTrades() const{
+    uint64_t total = 0;
+    for (const auto& worker : workers)
+        total += worker->nTrades.load(std::memory_order_relaxed);
+    return total;
+}
+
+
+uint64_t Exchange::getNumberOfRejectedCommands() const{
+    uint64_t total = 0;
+    for (const auto& worker : workers)
+        total += worker->nRejected.load(std::memory_order_relaxed);
+    return total;
+}
+
+
+OrderBook& Exchange::getOrderBook(SymbolId symbol){
+    if (symbol >= books.size())
+        throw std::out_of_range((std::ostringstream{} << "Unknown symbol (" << symbol << ")").str());
+    return *books[symbol];
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "enums.h"
+#include "OrderCommand.h"
+#include "OrderBook.h"
+#include "SpscQueue.h"
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+/*  Multi-instrument matching engine: one OrderBook per symbol, sharded over worker threads.
+    Each symbol is pinned to a single worker (symbol % nWorkers), which is the only thread touching its book, thus
+    independent books match in parallel and no lock is shared between workers (the book's own mutex is never contended).
+    Commands reach a worker through its own SPSC ring buffer: the Exchange must be fed by a single thread (the gateway).
+    Workers also expire the GFD & GTT orders of their books while idle, instead of one prune thread per book.   */
+class Exchange{
+private:
+    struct Worker{
+        SpscQueue<OrderCommand> inbound;
+        std::vector<SymbolId> symbols;  // Symbols pinned to this worker
+        std::thread thread;
+
+        uint64_t nSubmitted = 0;    // Written by the gateway thread only
+        alignas(64) std::atomic<uint64_t> nProcessed{0};    // Written by the worker only
+        std::atomic<uint64_t> nTrades{0};
+        std::atomic<uint64_t> nRejected{0};     // Commands that threw (e.g. invalid price or number of shares)
+
+        Worker(size_t queueCapacity): inbound(queueCapacity) {}
+    };
+
+    std::vector<std::unique_ptr<OrderBook>> books;  // Indexed by symbol
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping{false};
+
+    Worker& getWorker(SymbolId symbol) {return *workers[symbol % workers.size()];}
+
+    void run(Worker& worker);
+
+    void execute(Worker& worker, const OrderCommand& command);
+
+public:
+    /*  nSymbols: symbols are numbered from 0 to nSymbols - 1
+        nWorkers: number of matching threads (0 -> one per hardware thread), capped to nSymbols
+        queueCapacity: size of each worker's inbound ring buffer
+        expectedOrdersPerBook: pre-sizing hint for each order book   */
+    Exchange(size_t nSymbols, size_t nWorkers = 0, size_t queueCapacity = 1 << 16, size_t expectedOrdersPerBook = 0,
+                LogVerbosity verbosity = LogVerbosity::Silent);
+    ~Exchange();    // Processes the pending commands, then stops the workers
+
+    Exchange(const Exchange&) = delete;
+    Exchange& operator=(const Exchange&) = delete;
+
+    size_t getNumberOfSymbols() const {return books.size();}
+    size_t getNumberOfWorkers() const {return workers.size();}
+    size_t getWorkerOf(SymbolId symbol) const {return symbol % workers.size();}
+
+    // Gateway side: enqueue a command for the worker owning its symbol, waiting while its ring buffer is full
+    void submit(const OrderCommand& command);
+    bool trySubmit(const OrderCommand& command);    // Doesn't wait, returns false if the ring buffer is full
+
+    void addOrder(const Order& order) {submit(OrderCommand::add(order));}
+    void cancelOrder(SymbolId symbol, OrderId orderId) {submit(OrderCommand::cancel(symbol, orderId));}
+    void amendOrder(SymbolId symbol, OrderId orderId, Price newPrice, Quantity newShares) {
+        submit(OrderCommand::amend(symbol, orderId, newPrice, newShares));
+    }
+
+    void drain();   // Wait until every submitted command has been processed
+
+    // Statistics, up to date once drained
+    uint64_t getNumberOfProcessedCommands() const;
+    uint64_t getNumberOfTrades() const;
+    uint64_t getNumberOfRejectedCommands() const;
+
+    // Direct access to a book: only safe while the exchange is drained and no command is being submitted
+    OrderBook& getOrderBook(SymbolId symbol);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "enums.h"
+#include "Trade.h"
+
+#include <cstdint>
+#include <cstddef>
+
+/*  Executions are pushed to a listener as the fills happen, instead of being collected into a Trades vector.
+    Listeners derive from ExecutionListener<Derived> (CRTP): the order book calls them through the base class template,
+    thus the call is resolved at compile time and inlined into the matching loop (no virtual call, no allocation).   */
+
+struct Execution{
+    OrderId bidOrderId;
+    OrderId askOrderId;
+    Price bidPrice;     // Limit price of each order (market orders: the trade price)
+    Price askPrice;
+    Quantity shares;
+    Side aggressor;     // Side of the incoming order that crossed the book
+
+    OrderId restingOrderId() const {return (aggressor == Side::Bid) ? askOrderId : bidOrderId;}
+    Price price() const {return (aggressor == Side::Bid) ? askPrice : bidPrice;}   // Trade price: the resting order's price
+};
+
+
+template<typename Derived>
+class ExecutionListener{
+public:
+    // Called by the order book for every fill, while it holds its lock: listeners should only record the execution
+    void execution(const Execution& execution) {static_cast<Derived*>(this)->onExecution(execution);}
+
+    void onExecution(const Execution&) {}   // Default: executions are ignored, hidden by the derived listener's own
+
+protected:
+    ~ExecutionListener() = default;     // Listeners are never used polymorphically
+};
+
+
+// Ignore executions, e.g. when only the state of the book matters
+class NullListener : public ExecutionListener<NullListener> {};
+
+
+class TradeCounter : public ExecutionListener<TradeCounter>{
+public:
+    size_t nTrades = 0;
+
+    void onExecution(const Execution&) {++nTrades;}
+};
+
+
+// Adapter to the Trades API: appends one Trade per execution to the given buffer
+class TradesCollector : public ExecutionListener<TradesCollector>{
+private:
+    Trades& trades;
+
+public:
+    explicit TradesCollector(Trades& _trades): trades(_trades) {}
+
+    void onExecution(const Execution& execution){
+        trades.emplace_back(TradeInfo{execution.bidOrderId, execution.bidPrice, execution.shares},
+                            TradeInfo{execution.askOrderId, execution.askPrice, execution.shares});
+    }
+};
@@ -0,0 +1,325 @@
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+#include "Journal.h"
+#include "OrderFile.h"
+#include "OrderBook.h"
+
+
+JournalReader::JournalReader(const std::string& filename): file(filename){
+    if (file.size() < sizeof(JournalFileHeader))
+        throw std::runtime_error((std::ostringstream{} << filename << " is too small to be a journal").str());
+
+    const JournalFileHeader& header = *reinterpret_cast<const JournalFileHeader*>(file.data());
+
+    if (std::memcmp(header.magic, JOURNAL_FILE_MAGIC, sizeof(JOURNAL_FILE_MAGIC)) != 0)
+        throw std::runtime_error((std::ostringstream{} << filename << " is not a journal").str());
+
+    if (header.version != JOURNAL_FILE_VERSION || header.recordSize != sizeof(JournalRecord))
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " has an unsupported version (" << header.version << ") or record size (" << header.recordSize << ")").str()
+        );
+
+    if (std::abs(header.tickSize - DEFAULT_TICK_SIZE) > 1e-12)
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " has a tick size of " << header.tickSize << " instead of " << DEFAULT_TICK_SIZE).str()
+        );
+
+    records = reinterpret_cast<const JournalRecord*>(file.data() + sizeof(JournalFileHeader));
+    const size_t nWholeRecords = (file.size() - sizeof(JournalFileHeader)) / sizeof(JournalRecord);
+
+    // The journal ends at the first record that isn't the next one: torn by a crash, or never written
+    while (nRecords < nWholeRecords && records[nRecords].sequence == records[0].sequence + nRecords
+            && records[nRecords].checksum == records[nRecords].computeChecksum())
+        ++nRecords;
+
+    truncated = validBytes() != file.size();
+}
+
+
+JournalWriter::JournalWriter(const std::string& _filename, JournalOptions _options): filename(_filename), options(_options){
+    size_t validBytes = 0;
+
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA fileStatus;
+    const bool exists = GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &fileStatus)
+                        && (fileStatus.nFileSizeLow != 0 || fileStatus.nFileSizeHigh != 0);
+#else
+    struct stat fileStatus;
+    const bool exists = ::stat(filename.c_str(), &fileStatus) == 0 && fileStatus.st_size > 0;
+#endif
+
+    if (exists){    // Continue the journal after its last valid record
+        JournalReader reader(filename);
+        validBytes = reader.validBytes();
+        lastSequence = reader.lastSequence();
+        durableSequence.store(lastSequence, std::memory_order_release);
+    }
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE){
+        fileHandle = nullptr;
+        throw std::runtime_error((std::ostringstream{} << "Cannot open journal " << filename << " for writing").str());
+    }
+
+    LARGE_INTEGER offset;
+    offset.QuadPart = static_cast<LONGLONG>(validBytes);
+    const bool positioned = SetFilePointerEx(fileHandle, offset, nullptr, FILE_BEGIN) && SetEndOfFile(fileHandle);
+#else
+    fileDescriptor = ::open(filename.c_str(), O_WRONLY | O_CREAT, 0644);
+    if (fileDescriptor < 0)
+        throw std::runtime_error((std::ostringstream{} << "Cannot open journal " << filename << " for writing").str());
+
+    const bool positioned = ::ftruncate(fileDescriptor, static_cast<off_t>(validBytes)) == 0
+                            && ::lseek(fileDescriptor, static_cast<off_t>(validBytes), SEEK_SET) == static_cast<off_t>(validBytes);
+#endif
+
+    if (!positioned){
+        close();
+        throw std::runtime_error((std::ostringstream{} << "Cannot cut the torn tail of journal " << filename).str());
+    }
+
+    try{
+        if (validBytes == 0){
+            JournalFileHeader header{};
+            std::memcpy(header.magic, JOURNAL_FILE_MAGIC, sizeof(JOURNAL_FILE_MAGIC));
+            header.version = JOURNAL_FILE_VERSION;
+            header.recordSize = sizeof(JournalRecord);
+            header.tickSize = DEFAULT_TICK_SIZE;
+            writeBytes(&header, sizeof(header));
+            if (options.sync)
+                syncFile();
+        }
+    }
+    catch (...){
+        close();
+        throw;
+    }
+
+    pending.reserve(options.batchRecords);
+    writing.reserve(options.batchRecords);
+
+    flusher = std::thread([this] {
+                                    flushRecords();
+                                }
+                        );
+}
+
+
+JournalWriter::~JournalWriter(){
+    {
+        std::unique_lock<std::mutex> bufferLock{bufferMutex};
+        stopping = true;
+    }
+    flushRequested.notify_one();
+
+    if (flusher.joinable())
+        flusher.join();     // The flusher writes what's pending before it returns
+
+    close();
+}
+
+
+void JournalWriter::close(){
+#ifdef _WIN32
+    if (fileHandle != nullptr)
+        CloseHandle(fileHandle);
+    fileHandle = nullptr;
+#else
+    if (fileDescriptor >= 0)
+        ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+}
+
+
+void JournalWriter::writeBytes(const void* data, size_t size){
+    /* Throws std::runtime_error if the bytes can't all be written */
+    const char* bytes = static_cast<const char*>(data);
+
+    while (size > 0){
+#ifdef _WIN32
+        DWORD written = 0;
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        if (!WriteFile(fileHandle, bytes, chunk, &written, nullptr))
+            throw std::runtime_error((std::ostringstream{} << "Failed to write to journal " << filename).str());
+#else
+        const ssize_t written = ::write(fileDescriptor, bytes, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            throw std::runtime_error((std::ostringstream{} << "Failed to write to journal " << filename << ": " << std::strerror(errno)).str());
+#endif
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+
+void JournalWriter::writeRecords(const JournalRecord* records, size_t nRecords){
+    /* One write for the whole batch, then a single sync (if enabled) which makes every record of the batch durable */
+    writeBytes(records, nRecords * sizeof(JournalRecord));
+
+    if (options.sync)
+        syncFile();
+}
+
+
+void JournalWriter::syncFile(){
+#ifdef _WIN32
+    const bool synced = FlushFileBuffers(fileHandle);
+#elif defined(__APPLE__)
+    const bool synced = ::fsync(fileDescriptor) == 0;
+#else
+    const bool synced = ::fdatasync(fileDescriptor) == 0;   // The data & the file size, not the access times
+#endif
+
+    if (!synced)
+        throw std::runtime_error((std::ostringstream{} << "Failed to sync journal " << filename).str());
+}
+
+
+void JournalWriter::flushRecords(){
+    /*  Take every pending record at once (the buffers are swapped, thus the book appends to an empty buffer meanwhile),
+        checksum them, write & sync them outside of the lock, then wake up the callers waiting for them.   */
+    std::unique_lock<std::mutex> bufferLock{bufferMutex};
+
+    while (true){
+        flushRequested.wait_for(bufferLock, options.flushInterval,
+                                [this] {return stopping || syncRequested || pending.size() >= options.batchRecords;});
+
+        if (pending.empty()){
+            syncRequested = false;
+            if (stopping)
+                return;
+            continue;
+        }
+
+        writing.swap(pending);
+        syncRequested = false;
+        bufferLock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        try{
+            for (JournalRecord& record : writing)
+                record.checksum = record.computeChecksum();
+
+            writeRecords(writing.data(), writing.size());
+        }
+        catch (const std::exception& e){
+            bufferLock.lock();
+            failure = e.what();
+            failed.store(true, std::memory_order_release);
+            batchDurable.notify_all();
+            return;     // Nothing is written after a failed batch: the journal stays a prefix of the applied commands
+        }
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        bufferLock.lock();
+        durableSequence.store(writing.back().sequence, std::memory_order_release);
+        stats.nRecords += writing.size();
+        stats.nBatches += 1;
+        stats.nBytes += writing.size() * sizeof(JournalRecord);
+        stats.syncTime += elapsed;
+        writing.clear();
+
+        batchDurable.notify_all();
+    }
+}
+
+
+void JournalWriter::waitDurable(uint64_t sequence){
+    std::unique_lock<std::mutex> bufferLock{bufferMutex};
+
+    if (sequence > lastSequence)
+        throw std::invalid_argument((std::ostringstream{} << "Record " << sequence << " wasn't appended to journal " << filename).str());
+
+    // Group commit: the flusher is woken up now, and the records appended meanwhile go in the same batch
+    while (durableSequence.load(std::memory_order_acquire) < sequence){
+        if (failed.load(std::memory_order_acquire))
+            throw std::runtime_error(failure);
+
+        syncRequested = true;
+        flushRequested.notify_one();
+        batchDurable.wait(bufferLock);
+    }
+}
+
+
+void JournalWriter::flush(){
+    waitDurable(getLastSequence());
+}
+
+
+uint64_t JournalWriter::getLastSequence(){
+    std::unique_lock<std::mutex> bufferLock{bufferMutex};
+    return lastSequence;
+}
+
+
+JournalStats JournalWriter::getStats(){
+    std::unique_lock<std::mutex> bufferLock{bufferMutex};
+    return stats;
+}
+
+
+
+template<typename Listener>
+JournalReplayResult replayJournal(const std::string& filename, OrderBook& book, ManualWallClock& clock, ExecutionListener<Listener>& listener){
+    /*  Each record goes through the same API as the command it journaled, thus through the same checks. The records are
+        valid as they were accepted by a book, an invalid one means that the journal doesn't come from a book with the same rules.   */
+    JournalReader reader(filename);
+    JournalReplayResult result;
+
+    for (const JournalRecord& record : reader){
+        clock.set(record.time());
+
+        switch (record.entry){
+            case JournalEntry::Add:
+                if (record.type == Type::M)
+                    book.addMarketOrder(record.toOrder(), record.price, record.leftover, listener);
+                else
+                    book.addOrder(record.toOrder(), listener);
+                break;
+            case JournalEntry::Cancel:
+                book.cancelOrder(record.orderId);
+                break;
+            case JournalEntry::Amend:
+                book.amendOrder(record.orderId, record.price, record.shares, listener);
+                break;
+            case JournalEntry::Expire:
+                book.expireOrder(record.orderId);
+                break;
+            default:
+                throw std::runtime_error(
+                    (std::ostringstream{} << filename << " has a record of unknown type (sequence " << record.sequence << ")").str()
+                );
+        }
+
+        ++result.nRecords;
+        result.lastSequence = record.sequence;
+    }
+
+    result.truncated = reader.isTruncated();
+    return result;
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+#include "WallClock.h"
+#include "BookFile.h"
+#include "OrderFile.h"
+#include "ExecutionListener.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+/*  Write-ahead journal of the commands accepted by an order book (OrderBook::attachJournal), little endian:
+        - a 32-byte header
+        - one 48-byte record per command, in the order the book applied them: an add once its admission checks passed,
+          a cancel or amend of a resting order, and the expiry of an order
+    The records are appended to a buffer while the book holds its lock, and a flusher thread writes & syncs them in batches
+    (group commit): every command accepted during a flush interval shares a single write & fsync. Callers that must not
+    acknowledge a command before it is durable wait for its sequence (JournalWriter::waitDurable).
+    Each record has the time of the command & a checksum: replaying the journal into an empty book with the same clock
+    (see replayJournal in Journal.cpp) makes the same decisions, thus rebuilds the same book & the same trades.
+    A record torn by a crash fails its checksum, the journal ends at the last valid record.   */
+
+constexpr char JOURNAL_FILE_MAGIC[8] = {'O', 'B', 'J', 'O', 'U', 'R', 'N', 'L'};
+constexpr uint32_t JOURNAL_FILE_VERSION = 1;
+
+enum class JournalEntry : uint8_t {Add = 0, Cancel, Amend, Expire};
+
+struct JournalFileHeader{
+    char magic[8];          // JOURNAL_FILE_MAGIC
+    uint32_t version;       // JOURNAL_FILE_VERSION
+    uint32_t recordSize;    // sizeof(JournalRecord)
+    double tickSize;        // Prices are stored in ticks of tickSize
+    uint64_t reserved;
+};
+
+struct JournalRecord{
+    uint64_t sequence;      // 1, 2, ... in the order the commands were applied
+    int64_t timestamp;      // Time of the command (book clock), nanoseconds since the Unix epoch
+    OrderId orderId;
+    Price price;            // Add: limit price (market orders: protection price, 0 if none); Amend: new price
+    Quantity shares;        // Add: shares; Amend: new shares
+    ExpiryTime expiry;      // Add of a GTT order
+    SymbolId symbol;
+    JournalEntry entry;
+    Type type;
+    Side side;
+    MarketLeftover leftover;    // Add of a market order
+    uint8_t padding[2];
+    uint64_t checksum;      // Of the 40 bytes above, set by the flusher
+
+    static int64_t toTimestamp(std::chrono::system_clock::time_point time){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    std::chrono::system_clock::time_point time() const{
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamp)));
+    }
+
+    static JournalRecord add(const Order& order, std::chrono::system_clock::time_point time, Price protectionPrice = 0,
+                                MarketLeftover leftover = MarketLeftover::Rest){
+        const bool market = order.getOrderType() == Type::M;
+        return JournalRecord{0, toTimestamp(time), order.getOrderId(), market ? protectionPrice : order.getOrderPrice(), order.getOrderShares(),
+                                order.getOrderExpiry(), order.getOrderSymbol(), JournalEntry::Add, order.getOrderType(), order.getOrderSide(), leftover, {}, 0};
+    }
+
+    static JournalRecord cancel(OrderId orderId, std::chrono::system_clock::time_point time){
+        return JournalRecord{0, toTimestamp(time), orderId, 0, 0, 0, 0, JournalEntry::Cancel, Type::GTC, Side::Bid, MarketLeftover::Rest, {}, 0};
+    }
+
+    static JournalRecord amend(OrderId orderId, Price newPrice, Quantity newShares, std::chrono::system_clock::time_point time){
+        return JournalRecord{0, toTimestamp(time), orderId, newPrice, newShares, 0, 0, JournalEntry::Amend, Type::GTC, Side::Bid, MarketLeftover::Rest, {}, 0};
+    }
+
+    static JournalRecord expire(OrderId orderId, std::chrono::system_clock::time_point time){
+        return JournalRecord{0, toTimestamp(time), orderId, 0, 0, 0, 0, JournalEntry::Expire, Type::GTC, Side::Bid, MarketLeftover::Rest, {}, 0};
+    }
+
+    Order toOrder() const{
+        /* The order of an Add record (may throw std::invalid_argument, see the Order constructors) */
+        if (type == Type::M)
+            return Order(orderId, type, side, shares, symbol);
+
+        Order order(orderId, type, side, price, shares, symbol);
+        if (type == Type::GTT)
+            order.setExpiry(expiry);
+        return order;
+    }
+
+    uint64_t computeChecksum() const{
+        BookFileChecksum hash;
+        hash.update(this, offsetof(JournalRecord, checksum));
+        return hash.value();
+    }
+};
+
+static_assert(sizeof(JournalFileHeader) == 32, "The journal header layout must not depend on the compiler");
+static_assert(sizeof(JournalRecord) == 48, "The journal record layout must not depend on the compiler");
+static_assert(offsetof(JournalRecord, checksum) % sizeof(uint64_t) == 0, "The checksum covers whole 8-byte words");
+
+
+struct JournalOptions{
+    size_t batchRecords = 4096;     // The flusher starts a batch as soon as this many records are pending...
+    std::chrono::microseconds flushInterval{1000};  // ... or once per interval otherwise (the group commit window)
+    bool sync = true;               // fsync each batch, otherwise the records are durable once the OS writes them back
+};
+
+struct JournalStats{
+    uint64_t nRecords = 0;      // Written to the file
+    uint64_t nBatches = 0;      // Writes (and fsyncs) of the flusher
+    uint64_t nBytes = 0;
+    double syncTime = 0.0;      // Total time spent in write + fsync by the flusher (ms)
+};
+
+
+/*  Appends the records of one order book to a journal file. An existing journal is continued: its torn tail (if any) is cut
+    and the sequence numbers go on from its last valid record, thus a recovered book can keep journaling to the same file.
+    The constructor throws std::runtime_error if the file can't be opened or isn't a journal. If a write fails the error is
+    kept, and append & waitDurable throw it, thus the book stops accepting commands it can't journal.   */
+class JournalWriter{
+private:
+    std::string filename;
+    JournalOptions options;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    std::mutex bufferMutex;
+    std::condition_variable flushRequested;     // Wakes the flusher up before the end of its interval
+    std::condition_variable batchDurable;       // Wakes the callers of waitDurable up
+    std::vector<JournalRecord> pending;         // Appended, not written yet
+    std::vector<JournalRecord> writing;         // Batch being written by the flusher (pending's memory in the next round)
+    uint64_t lastSequence = 0;                  // Of the last appended record
+    bool syncRequested = false;
+    bool stopping = false;
+    std::atomic<uint64_t> durableSequence{0};   // Every record up to this sequence is in the file
+    std::atomic<bool> failed{false};
+    std::string failure;
+    JournalStats stats;
+
+    std::thread flusher;
+
+    void flushRecords();    // Body of flusher
+    // Throw std::runtime_error if the write or the sync fails
+    void writeRecords(const JournalRecord* records, size_t nRecords);
+    void writeBytes(const void* data, size_t size);
+    void syncFile();
+    void close();
+
+public:
+    explicit JournalWriter(const std::string& filename, JournalOptions options = {});
+    ~JournalWriter();   // Writes the pending records
+
+    JournalWriter(const JournalWriter&) = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    uint64_t append(JournalRecord record){
+        /* Called by the order book under its lock: the record is only buffered, returns its sequence number */
+        if (failed.load(std::memory_order_acquire))
+            throwFailure();
+
+        std::unique_lock<std::mutex> bufferLock{bufferMutex};
+        record.sequence = ++lastSequence;
+        pending.push_back(record);
+
+        if (pending.size() == options.batchRecords)
+            flushRequested.notify_one();
+        return record.sequence;
+    }
+
+    void waitDurable(uint64_t sequence);    // Block until the record of this sequence (and every one before it) is durable
+    void flush();                           // waitDurable of the last appended record
+
+    uint64_t getLastSequence();
+    uint64_t getDurableSequence() const {return durableSequence.load(std::memory_order_acquire);}
+    JournalStats getStats();
+
+    [[noreturn]] void throwFailure(){
+        std::unique_lock<std::mutex> bufferLock{bufferMutex};
+        throw std::runtime_error(failure);
+    }
+};
+
+
+// Validated view of a journal file (memory mapped): the records up to the first torn or corrupted one
+class JournalReader{
+private:
+    MappedFile file;
+    const JournalRecord* records = nullptr;
+    size_t nRecords = 0;
+    bool truncated = false;     // Bytes were left after the last valid record (e.g. a write torn by a crash)
+
+public:
+    explicit JournalReader(const std::string& filename);    // Throws std::runtime_error if the file isn't a journal
+
+    size_t size() const {return nRecords;}
+    bool isTruncated() const {return truncated;}
+    size_t validBytes() const {return sizeof(JournalFileHeader) + nRecords * sizeof(JournalRecord);}
+    uint64_t lastSequence() const {return (nRecords == 0) ? 0 : records[nRecords - 1].sequence;}
+
+    const JournalRecord* begin() const {return records;}
+    const JournalRecord* end() const {return records + nRecords;}
+};
+
+
+struct JournalReplayResult{
+    uint64_t nRecords = 0;      // Applied to the book
+    uint64_t lastSequence = 0;
+    bool truncated = false;     // The journal ended with a torn record, which was ignored
+};
+
+
+class OrderBook;
+
+/*  Apply the records of a journal to an empty order book, in order, reporting the executions to listener: the same book &
+    the same trades as when the journal was written. clock is the clock of book (constructed without its pruning thread):
+    it's set to the time of each record before the record is applied, thus the expiry checks & the close of GFD orders
+    are the same, and the orders expire where their Expire record is. Defined in Journal.cpp.   */
+template<typename Listener>
+JournalReplayResult replayJournal(const std::string& filename, OrderBook& book, ManualWallClock& clock, ExecutionListener<Listener>& listener);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <limits>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*  HDR-style latency histogram with constant memory and O(1) recording (values are in nanoseconds).
+    Values below 2^SUB_BUCKET_BITS are counted exactly; above, each power of 2 is split into 2^(SUB_BUCKET_BITS - 1) linear
+    sub-buckets, thus any recorded value is known within a relative error of 1 / 2^(SUB_BUCKET_BITS - 1) (~1.6%).
+    Min, max, mean and variance are tracked exactly.   */
+class LatencyHistogram{
+private:
+    static constexpr uint32_t SUB_BUCKET_BITS = 7;
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;       // 128
+    static constexpr uint32_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT / 2;        // 64
+    static constexpr uint32_t N_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+
+    std::array<uint64_t, N_BUCKETS> counts{};
+    uint64_t totalCount = 0;
+    uint64_t minValue = std::numeric_limits<uint64_t>::max();
+    uint64_t maxValue = 0;
+    double sum = 0.0;
+    double sumOfSquares = 0.0;
+
+    static uint32_t mostSignificantBit(uint64_t value){
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static uint32_t bucketIndex(uint64_t value){
+        if (value < SUB_BUCKET_COUNT)
+            return static_cast<uint32_t>(value);
+
+        const uint32_t shift = mostSignificantBit(value) - (SUB_BUCKET_BITS - 1);  // >= 1, keeps the 7 most significant bits
+        return shift * SUB_BUCKET_HALF + static_cast<uint32_t>(value >> shift);
+    }
+
+    static uint64_t bucketHighestValue(uint32_t index){
+        /* Highest value that falls into the given bucket */
+        if (index < SUB_BUCKET_COUNT)
+            return index;
+
+        const uint32_t shift = index / SUB_BUCKET_HALF - 1;
+        const uint64_t subBucket = index % SUB_BUCKET_HALF + SUB_BUCKET_HALF;
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t nanoseconds){
+        ++counts[bucketIndex(nanoseconds)];
+        ++totalCount;
+        minValue = std::min(minValue, nanoseconds);
+        maxValue = std::max(maxValue, nanoseconds);
+
+        const double value = static_cast<double>(nanoseconds);
+        sum += value;
+        sumOfSquares += value * value;
+    }
+
+    void merge(const LatencyHistogram& other){
+        /* Add the values recorded by other (e.g. per-thread histograms) */
+        for (uint32_t index = 0; index < N_BUCKETS; ++index)
+            counts[index] += other.counts[index];
+        totalCount += other.totalCount;
+        minValue = std::min(minValue, other.minValue);
+        maxValue = std::max(maxValue, other.maxValue);
+        sum += other.sum;
+        sumOfSquares += other.sumOfSquares;
+    }
+
+    void clear() {*this = LatencyHistogram{};}
+
+    uint64_t count() const {return totalCount;}
+    bool empty() const {return totalCount == 0;}
+    uint64_t min() const {return empty() ? 0 : minValue;}
+    uint64_t max() const {return maxValue;}
+    double mean() const {return empty() ? 0.0 : sum / totalCount;}
+
+    double variance() const{
+        if (empty())
+            return 0.0;
+        const double average = mean();
+        return std::max(0.0, sumOfSquares / totalCount - average * average);
+    }
+
+    uint64_t percentile(double percent) const{
+        /* Value below which percent% of the recorded values fall (within the histogram's precision) */
+        if (empty())
+            return 0;
+
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percent / 100.0 * totalCount)));
+        uint64_t cumulativeCount = 0;
+
+        for (uint32_t index = 0; index < N_BUCKETS; ++index){
+            cumulativeCount += counts[index];
+            if (cumulativeCount >= rank)
+                return std::min(bucketHighestValue(index), maxValue);
+        }
+        return maxValue;
+    }
+};
@@ -1,11 +1,14 @@
 #pragma once
 
+#include "enums.h"
+
 #include <cstdint>
 #include <vector>
 
 struct LimitLevelInfo{
-    double price;
+    Price price;
     uint32_t totalShares;
+    uint32_t totalOrders;
 };
 
 using LimitLevelInfos = std::vector<LimitLevelInfo>;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "enums.h"
+#include "LimitLevel.h"
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <functional>
+#include <utility>
+#include <algorithm>
+
+/*  Incremental L2 (market by price) feed: the order book publishes one LevelUpdate each time the total shares or number of
+    orders of a limit level change, the level appears or disappears. Every update gets the next sequence number of the book.
+    A consumer starts from a BookSnapshot, taken atomically with its subscription, and applies the updates that follow
+    the snapshot's sequence number (see DepthBook), thus it never has to scan the book.   */
+
+enum class LevelAction : uint8_t {Add = 0, Update, Delete};
+
+struct LevelUpdate{
+    uint64_t sequence;
+    Price price;
+    uint32_t totalShares;   // New totals of the level (0 when deleted)
+    uint32_t totalOrders;
+    Side side;
+    LevelAction action;
+};  // 24 bytes
+
+struct BookSnapshot{
+    uint64_t sequence = 0;  // Sequence number of the last update included in the snapshot
+    LimitLevelInfos bids;   // Best (highest) price first
+    LimitLevelInfos asks;   // Best (lowest) price first
+};
+
+using SubscriptionId = uint32_t;
+
+using LevelUpdateHandler = std::function<void(const LevelUpdate&)>;
+
+
+// Publisher side, owned by the order book: handlers are called synchronously by the matching thread, under the book's lock
+class MarketDataFeed{
+private:
+    std::vector<std::pair<SubscriptionId, LevelUpdateHandler>> subscribers;
+    SubscriptionId nextSubscriptionId = 0;
+    uint64_t sequence = 0;
+
+public:
+    uint64_t getSequence() const {return sequence;}
+    bool hasSubscribers() const {return !subscribers.empty();}
+
+    void publish(Side side, Price price, uint32_t totalShares, uint32_t totalOrders, LevelAction action){
+        /* The sequence number is incremented even without subscribers, thus snapshots always tell where the book is */
+        ++sequence;
+        if (subscribers.empty())
+            return;
+
+        const LevelUpdate update{sequence, price, totalShares, totalOrders, side, action};
+        for (const auto& subscriber : subscribers)
+            subscriber.second(update);
+    }
+
+    SubscriptionId subscribe(LevelUpdateHandler handler){
+        subscribers.emplace_back(nextSubscriptionId, std::move(handler));
+        return nextSubscriptionId++;
+    }
+
+    void unsubscribe(SubscriptionId id){
+        subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), [id](const auto& subscriber) {return subscriber.first == id;}),
+                            subscribers.end());
+    }
+};
+
+
+struct MarketDataSubscription{
+    SubscriptionId id;
+    BookSnapshot snapshot;  // State of the book right before the first update delivered to the handler
+};
+
+
+// Consumer side: depth of the book rebuilt from a snapshot and the updates that follow it
+class DepthBook{
+private:
+    std::map<Price, LimitLevelInfo, std::greater<Price>> bids;
+    std::map<Price, LimitLevelInfo> asks;
+    uint64_t sequence = 0;
+
+public:
+    void reset(const BookSnapshot& snapshot){
+        bids.clear();
+        asks.clear();
+        for (const auto& level : snapshot.bids)
+            bids[level.price] = level;
+        for (const auto& level : snapshot.asks)
+            asks[level.price] = level;
+        sequence = snapshot.sequence;
+    }
+
+    bool apply(const LevelUpdate& update){
+        /*  Returns false if an update is missing (the depth is stale and a new snapshot is needed).
+            Updates already included in the snapshot are ignored.   */
+        if (update.sequence <= sequence)
+            return true;
+        if (update.sequence != sequence + 1)
+            return false;
+        sequence = update.sequence;
+
+        auto applyTo = [&](auto& levels){
+            if (update.action == LevelAction::Delete)
+                levels.erase(update.price);
+            else
+                levels[update.price] = LimitLevelInfo{update.price, update.totalShares, update.totalOrders};
+        };
+
+        if (update.side == Side::Bid)
+            applyTo(bids);
+        else
+            applyTo(asks);
+        return true;
+    }
+
+    uint64_t getSequence() const {return sequence;}
+
+    LimitLevelInfos getBids(size_t depth = SIZE_MAX) const {return topLevels(bids, depth);}
+    LimitLevelInfos getAsks(size_t depth = SIZE_MAX) const {return topLevels(asks, depth);}
+
+private:
+    template<typename Levels>
+    static LimitLevelInfos topLevels(const Levels& levels, size_t depth){
+        LimitLevelInfos result;
+        for (auto it = levels.begin(); it != levels.end() && result.size() < depth; ++it)
+            result.push_back(it->second);
+        return result;
+    }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/*  Bounded lock-free multi-producer/single-consumer ring buffer (D. Vyukov's bounded queue).
+    Any number of threads may push concurrently, exactly one thread may pop. Each cell carries a sequence number telling
+    whether it's ready to be written (sequence == position) or read (sequence == position + 1), thus producers only
+    contend on one atomic increment of tail and never wait for each other to finish writing.
+    tryPush fails when the queue is full and tryPop fails when it is empty (or the next item isn't fully written yet).   */
+template<typename T>
+class MpscQueue{
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell{
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};   // Next position to write (shared by the producers)
+    alignas(CACHE_LINE_SIZE) size_t head = 0;   // Next position to read (owned by the consumer)
+
+    static size_t roundUpToPowerOf2(size_t n){
+        size_t capacity = 2;
+        while (capacity < n)
+            capacity *= 2;
+        return capacity;
+    }
+
+public:
+    explicit MpscQueue(size_t capacity): cells(new Cell[roundUpToPowerOf2(capacity)]), mask(roundUpToPowerOf2(capacity) - 1) {
+        for (size_t position = 0; position <= mask; ++position)
+            cells[position].sequence.store(position, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    size_t capacity() const {return mask + 1;}
+
+    bool tryPush(const T& item){
+        size_t position = tail.load(std::memory_order_relaxed);
+
+        while (true){
+            Cell& cell = cells[position & mask];
+            const intptr_t difference = static_cast<intptr_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position);
+
+            if (difference == 0){   // The cell is free: claim the position
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);   // Publish it to the consumer
+                    return true;
+                }
+            }
+            else if (difference < 0)    // The cell hasn't been read since the previous lap
+                return false;   // Full
+            else    // Another producer claimed this position
+                position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPop(T& item){
+        Cell& cell = cells[head & mask];
+
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1)
+            return false;   // Empty
+
+        item = cell.item;
+        cell.sequence.store(head + mask + 1, std::memory_order_release);  // Free the cell for the next lap
+        ++head;
+        return true;
+    }
+};
@@ -1,8 +1,8 @@
 #include "Order.h"
 
 
-Order::Order(uint32_t _orderId, Type _type, Side _side, double _price, uint32_t _shares)
-: orderId(_orderId), type(_type), side(_side)
+Order::Order(uint32_t _orderId, Type _type, Side _side, Price _price, uint32_t _shares, SymbolId _symbol)
+: orderId(_orderId), type(_type), side(_side), symbol(_symbol)
 {
     if (_price <= 0)
         throw std::invalid_argument(
@@ -17,8 +17,8 @@ Order::Order(uint32_t _orderId, Type _type, Side _side, double _price, uint32_t
     init_shares = shares = _shares;
 }
 
-Order::Order(uint32_t _orderId, Type _type, Side _side, uint32_t _shares)  // Market order constructor
-: orderId(_orderId), type(_type), side(_side)
+Order::Order(uint32_t _orderId, Type _type, Side _side, uint32_t _shares, SymbolId _symbol)  // Market order constructor
+: orderId(_orderId), type(_type), side(_side), symbol(_symbol), price(0)
 {
     if (_shares == 0)
         throw std::invalid_argument(
@@ -37,7 +37,31 @@ void Order::fillOrder(uint32_t tradedShares){
     shares -= tradedShares;
 }
 
-void Order::marketToGTC(double _price){
+void Order::reduceShares(uint32_t newShares){
+    if (newShares == 0 || newShares > shares)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << getOrderId() << ") can only be reduced to a strictly positive number of shares, at most " << shares).str()
+        );
+
+    shares = newShares;
+}
+
+void Order::modify(Price newPrice, uint32_t newShares){
+    if (newPrice <= 0)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << getOrderId() << ") should have a strictly positive price").str()
+        );
+
+    if (newShares == 0)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << getOrderId() << ") can't have zero shares").str()
+        );
+
+    price = newPrice;
+    init_shares = shares = newShares;
+}
+
+void Order::marketToGTC(Price _price){
     // Turn a market order into a Good till Cancel order
     if (_price <= 0)
         throw std::invalid_argument(
@@ -46,4 +70,19 @@ void Order::marketToGTC(double _price){
     
     price = _price;
     type = Type::GTC;
-}
\ No newline at end of file
+}
+
+
+void Order::setExpiry(ExpiryTime _expiry){
+    if (type != Type::GFD && type != Type::GTT)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << getOrderId() << ") of type " << toString(type) << " can't expire").str()
+        );
+
+    if (_expiry == 0)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << getOrderId() << ") should have a strictly positive expiry time").str()
+        );
+
+    expiry = _expiry;
+}
@@ -1,45 +1,61 @@
 # pragma once
 
 #include "enums.h"
+#include "WallClock.h"
 
 #include <cstdint>
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
-#include <memory>
-#include <list>
 
 class Order{
 private:
     uint32_t orderId;
     Type type;
     Side side;
-    double price;   // price should be int as it's used as a key for other maps
+    SymbolId symbol;    // Instrument of the order (fits in the padding after type & side)
+    Price price;    // in ticks, as it's used as a key for other maps
     uint32_t init_shares;    // the initial number of shares
     uint32_t shares;    // the current number of shares
+    ExpiryTime expiry = 0;  // GTT: given by the client, GFD: the market close, set by the order book when it rests
+
+    // Intrusive links to the previous/next orders of the same limit level (indices in the OrderPool)
+    PoolIndex prev = NULL_INDEX;
+    PoolIndex next = NULL_INDEX;
+
+    friend class OrderPool;
+    friend class OrderQueue;
+    friend struct BookOrderRecord;  // Restores partially filled orders from a book snapshot
 
 public:
     // Constructors
-    Order(uint32_t _orderId, Type _type, Side _side, double _price, uint32_t _shares); // Orders Constructor
+    Order(uint32_t _orderId, Type _type, Side _side, Price _price, uint32_t _shares, SymbolId _symbol = 0); // Orders Constructor
+
+    Order(uint32_t _orderId, Type _type, Side _side, uint32_t _shares, SymbolId _symbol = 0);  // Market orders Constructor
 
-    Order(uint32_t _orderId, Type _type, Side _side, uint32_t _shares);  // Market orders Constructor
+    template<typename T, IfDecimalPrice<T> = 0>
+    Order(uint32_t _orderId, Type _type, Side _side, T _price, uint32_t _shares, SymbolId _symbol = 0) = delete;  // Prices are in ticks (see toTicks)
 
     // Getters
     uint32_t getOrderId() const {return orderId;}
     Type getOrderType() const {return type;}
     Side getOrderSide() const {return side;} 
-    double getOrderPrice() const {return price;}
+    SymbolId getOrderSymbol() const {return symbol;}
+    Price getOrderPrice() const {return price;}
     uint32_t getOrderInitialShares() const {return init_shares;}
     uint32_t getOrderShares() const {return shares;}
+    ExpiryTime getOrderExpiry() const {return expiry;}
 
     // Other class methods
     bool isFilled() const {return (shares == 0);}
 
     void fillOrder(uint32_t tradedShares);
 
-    void marketToGTC(double _price);
-};
+    void marketToGTC(Price _price);
+
+    void reduceShares(uint32_t newShares);  // Size down in place (the order keeps its queue position)
 
-using OrderPointer = std::shared_ptr<Order>;
+    void modify(Price newPrice, uint32_t newShares);  // New price & size, as if it was a new order
 
-using OrderPointers = std::list<OrderPointer>;  // We use list not vector as list is a doubly linked list which makes operations at the front and back faster (O(1))
+    void setExpiry(ExpiryTime _expiry);   // Only GFD & GTT orders expire
+};
@@ -7,81 +7,141 @@
 #include <nlohmann/json.hpp>
 
 #include "OrderBook.h"
+#include "Journal.h"
 
 using json = nlohmann::json;
 
-static std::unordered_map<Type, std::string> map_types = {{Type::GTC, "GTC"}, {Type::FAK, "FAK"}, {Type::FOK, "FOK"}, {Type::GFD, "GFD"}, {Type::M, "M"}};
-static std::unordered_map<Side, std::string> map_sides = {{Side::Bid, "Bid"}, {Side::Ask, "Ask"}};
 
-void OrderBook::cancelGFDOrders(uint32_t TRADING_CLOSE_HOUR){ 
-    /*Cancel all Good For Day orders when the market closes at TRADING_CLOSE_HOUR*/
+std::chrono::system_clock::time_point OrderBook::nextMarketClose(std::chrono::system_clock::time_point now, uint32_t closeHour){
+    /* Next time the market closes after now (closeHour:00 local time), today or tomorrow if it's already past the close hour */
     using namespace std::chrono;    // Import everything from std::chrono
 
-    const auto closeTime = hours(TRADING_CLOSE_HOUR);  // Trading close hour set to TRADING_CLOSE_HOUR:00
+    // mktime reads the time zone state, thus calls from several threads (e.g. Exchange workers) are serialized
+    static std::mutex timeZoneMutex;
+    std::lock_guard<std::mutex> timeZoneLock{timeZoneMutex};
 
-	while (true) {
-        // Get the current system time
-		const auto now = system_clock::now();
-		const auto now_c = system_clock::to_time_t(now);
-		std::tm now_parts;		
-        localtime_s(&now_parts, &now_c);
+    std::tm now_parts = toLocalTime(system_clock::to_time_t(now));
 
-        // Adjust the time if it's past the close hour
-        if (now_parts.tm_hour >= closeTime.count())
-            now_parts.tm_mday += 1;  // Move to the next day if past close time
+    // Adjust the time if it's past the close hour
+    if (now_parts.tm_hour >= static_cast<int>(closeHour))
+        now_parts.tm_mday += 1;  // Move to the next day if past close time
 
-        // Set the target time to TRADING_CLOSE_HOUR:00 (market close)
-		now_parts.tm_hour = closeTime.count();
-		now_parts.tm_min = 0;
-		now_parts.tm_sec = 0;
+    // Set the target time to closeHour:00 (market close)
+    now_parts.tm_hour = closeHour;
+    now_parts.tm_min = 0;
+    now_parts.tm_sec = 0;
+    now_parts.tm_isdst = -1;    // The close may be on the other side of a daylight saving change
+
+    // Convert to system_clock time
+    return system_clock::from_time_t(mktime(&now_parts));
+}
+
+
+void OrderBook::pruneOrders(){
+    /*  Expire the GFD & GTT orders as they are due, one chunk at a time: the lock is released between chunks,
+        thus orders keep being processed while a large number of orders expire (e.g. every GFD order at the close)   */
+    while (!shutdown.load(std::memory_order_acquire)){
+        if (expireOrders() > 0){
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> ordersLock{_mutex};
+
+        // Wait for the next poll of the clock or the shutdown signal
+        if (shutdownConditionVariable.wait_for(ordersLock, EXPIRY_POLL_INTERVAL, [this] {return shutdown.load(std::memory_order_acquire);}))
+            return;
+    }
+}
+
+
+void OrderBook::scheduleExpiry(Order& order, std::chrono::system_clock::time_point now){
+    /* The caller holds the lock, order is the copy in the pool */
+    if (order.getOrderType() == Type::GFD){
+        // The clock may also move backward (a replay set to the time of its journal)
+        if (toExpiryTime(now) >= sessionClose || toExpiryTime(now) < sessionStart){
+            sessionStart = toExpiryTime(now);
+            sessionClose = toExpiryTime(nextMarketClose(now));
+        }
+
+        order.setExpiry(sessionClose);
+        dayOrders[sessionClose].push_back(order.getOrderId());
+    }
+    else if (order.getOrderType() == Type::GTT)
+        timedOrders.schedule(order.getOrderExpiry(), order.getOrderId());
+}
+
+
+void OrderBook::collectExpiredOrders(ExpiryTime now){
+    /* O(due orders): the GFD orders of each past market close are moved at once, the GTT orders come from the timer wheel */
+    for (auto it = dayOrders.begin(); it != dayOrders.end() && it->first <= now; it = dayOrders.erase(it)){
+        if (expiredOrders.empty())
+            expiredOrders.swap(it->second);
+        else
+            expiredOrders.insert(expiredOrders.end(), it->second.begin(), it->second.end());
+    }
+
+    timedOrders.advance(now, expiredOrders);
+}
 
-        // Convert to system_clock time
-        auto nextCloseTime = system_clock::from_time_t(mktime(&now_parts));
-        auto waitDuration = nextCloseTime - now + milliseconds(100);  // Allow a small buffer of 100 milliseconds
 
-        // Wait for the market close or shutdown signal
-		{
-            std::unique_lock<std::mutex> ordersLock{_mutex};
+size_t OrderBook::expireOrders(size_t maxOrders){
+    /*  Orders cancelled since they were scheduled are skipped (lazy deletion): the order of the same ID, if any, must
+        still be a GFD or GTT order whose expiry has passed, thus a reused ID is never expired early.
+        Every due order counts towards maxOrders, skipped or not, which bounds the time spent under the lock.   */
+    std::unique_lock<std::mutex> ordersLock{_mutex};
 
-            // Wait for shutdown signal or timeout
-            if (shutdown.load(std::memory_order_acquire) ||
-                            shutdownConditionVariable.wait_for(ordersLock, waitDuration) == std::cv_status::no_timeout)
-				return;
-		}
+    const auto time = clock.now();
+    const ExpiryTime now = toExpiryTime(time);
+    collectExpiredOrders(now);
 
-		std::vector<uint32_t> GFDorderIds;
+    for (size_t n = 0; n < maxOrders && !expiredOrders.empty(); ++n){
+        const OrderId orderId = expiredOrders.back();
+        expiredOrders.pop_back();
 
-        // Collect order IDs for GFD orders
-		{
-            std::unique_lock<std::mutex> lock{_mutex};
+        const OrderInfo* info = orders.find(orderId);
+        if (info == nullptr)
+            continue;
 
-            for (const auto& item : orders) {
-                const OrderInfo& entry = item.second;
-                const OrderPointer& orderPtr = entry.order;
+        const Order& order = pool[info->orderIndex];
+        const bool expires = order.getOrderType() == Type::GFD || order.getOrderType() == Type::GTT;
+        if (!expires || order.getOrderExpiry() > now)
+            continue;
 
-				if (orderPtr->getOrderType() != Type::GFD)
-					continue;
+        if (journal != nullptr)
+            journal->append(JournalRecord::expire(orderId, time));
 
-                    GFDorderIds.push_back(orderPtr->getOrderId());
-			}
-		}
+        eventLog.logOrder(EventType::ExpireOrder, order);
+        auto start = Timestamp::start();
+        recordCancelLatency(removeOrder(orderId, info->orderIndex), start);
+    }
 
-		cancelOrders(GFDorderIds);
-	}
+    publishView();
+    return expiredOrders.size();
 }
 
 
-void OrderBook::cancelOrders(std::vector<uint32_t> orderIds){
+bool OrderBook::expireOrder(uint32_t orderId){
     std::unique_lock<std::mutex> ordersLock{_mutex};
 
-    for (auto orderId : orderIds)
-        OrderBook::cancelOrder(orderId, false);
+    const OrderInfo* info = orders.find(orderId);
+    if (info == nullptr)
+        return false;
+
+    if (journal != nullptr)
+        journal->append(JournalRecord::expire(orderId, clock.now()));
+
+    eventLog.logOrder(EventType::ExpireOrder, pool[info->orderIndex]);
+    auto start = Timestamp::start();
+    recordCancelLatency(removeOrder(orderId, info->orderIndex), start);
+    publishView();
+    return true;
 }
 
 
-int OrderBook::updateLimitLevelData(double price, uint32_t shares, Action action){
+int OrderBook::updateLimitLevelData(Side side, Price price, uint32_t shares, Action action){
     /*  Arguments:
-            price: used to identify the limit level
+            side & price: used to identify the limit level
             shares: the number of shares subject to action
             action: the type of action that is applied to the limit level
 
@@ -89,18 +149,28 @@ int OrderBook::updateLimitLevelData(double price, uint32_t shares, Action action
             -1: if the last order from the limit level was removed
              1: if a new limit level was added
              0: else
+        The change is published to the market data subscribers.
     */
+    auto& data = (side == Side::Bid) ? bidData : askData;
+    auto& depth = (side == Side::Bid) ? bidDepth : askDepth;
+
+    depth.cover(price, data);   // Before the level changes, as a rebuild of the index reads the current levels
 
     // Check if the price exists in the data map
     auto it = data.find(price);
 
     if (it == data.end()){
         // If the price does not exist and the action is Add, create a new entry
-        if (action == Action::Add) 
+        if (action == Action::Add){
             data[price] = LimitLevelData{shares, 1}; // Initialize with shares and 1 order
+            depth.add(price, shares);
+            marketData.publish(side, price, shares, 1, LevelAction::Add);
+            if (view != nullptr)
+                updateViewLevel(side, price, shares, 1, LevelAction::Add);
+        }
         else
             // If the price does not exist and the action is not Add, do nothing
-            std::cerr << "Error: Attempted to modify a non-existent limit level with price " << price << std::endl;
+            std::cerr << "Error: Attempted to modify a non-existent limit level with price " << toDecimalPrice(price) << std::endl;
         return 1;
     }
 
@@ -111,66 +181,69 @@ int OrderBook::updateLimitLevelData(double price, uint32_t shares, Action action
     limitLevel.totalOrders += (action == Action::Remove) ? -1 : (action == Action::Add) ? 1 : 0;
     // Update the number of shares
     limitLevel.totalShares += (action == Action::Add) ? shares : -shares;
+    depth.add(price, (action == Action::Add) ? static_cast<int64_t>(shares) : -static_cast<int64_t>(shares));
 
     // Remove the limit level if it is empty
     if (limitLevel.totalOrders == 0) {
         data.erase(price);
+        depth.levelRemoved(price);
+        marketData.publish(side, price, 0, 0, LevelAction::Delete);
+        if (view != nullptr)
+            updateViewLevel(side, price, 0, 0, LevelAction::Delete);
         return -1;
     }
-    
+
+    marketData.publish(side, price, limitLevel.totalShares, limitLevel.totalOrders, LevelAction::Update);
+    if (view != nullptr)
+        updateViewLevel(side, price, limitLevel.totalShares, limitLevel.totalOrders, LevelAction::Update);
     return 0;
 }
 
 
-bool OrderBook::canFullyFill(Side side, double price, uint32_t quantity) const{
-    /* Tells if an order can be fully filled or not (We only use it for Fill Or Kill orders) */
+bool OrderBook::canFullyFill(Side side, Price price, uint32_t quantity) const{
+    /*  Tells if an order can be fully filled or not (We only use it for Fill Or Kill orders), i.e. whether the opposite side
+        holds at least quantity shares at or better than price: a single query of the cumulative depth, O(log ticks)   */
 
     if (!canMatch(side, price)) // Early exit if the order can't match at all
         return false;
 
-    if (side == Side::Bid){    // We are buying, thus match against asks (ascending)
-        for (const auto& item : asks){
-            Price askPrice = item.first;
-            auto& askOrders = item.second;
+    const CumulativeDepth& depth = (side == Side::Bid) ? askDepth : bidDepth;
+    if (depth.isEnabled())
+        return ((side == Side::Bid) ? depth.sharesAtOrBelow(price) : depth.sharesAtOrAbove(price)) >= quantity;
+
+    // The index is disabled (outlier prices), thus walk the levels from the best one, summing their shares
+    uint64_t available = 0;
 
+    if (side == Side::Bid){    // We are buying, thus match against asks (ascending)
+        asks.forEachLevel([&](Price askPrice, const OrderQueue&){
             if (askPrice > price)
-                break; // Can't match beyond the bid price
+                return false; // Can't match beyond the bid price
 
-            for (const auto& orderPtr : askOrders) {
-                quantity -= orderPtr->getOrderShares();
-                if (quantity <= 0)
-                    return true;
-            }
-        }
+            available += askData.at(askPrice).totalShares;
+            return available < quantity;
+        });
     }
     else {  // We are selling, thus match against bids (descending)
-        for (const auto& item : bids){
-                Price bidPrice = item.first;
-                auto& bidOrders = item.second;
-
+        bids.forEachLevel([&](Price bidPrice, const OrderQueue&){
             if (bidPrice < price)
-                break; // Can't match below the ask price
+                return false; // Can't match below the ask price
 
-            for (const auto& orderPtr : bidOrders) {
-                quantity -= orderPtr->getOrderShares();
-                if (quantity <= 0)
-                    return true;
-            }
-        }
+            available += bidData.at(bidPrice).totalShares;
+            return available < quantity;
+        });
     }
 
-    return false;
+    return available >= quantity;
 }
 
 
-bool OrderBook::canMatch(Side side, double price) const{
+bool OrderBook::canMatch(Side side, Price price) const{
     /* Tells whether an order of 'side' side and 'price' price can match an order in the order side of the orderbook */
     if (side == Side::Bid){
         if (asks.empty())
             return false;
 
-        const auto& item = *asks.begin();
-        double bestAskPrice = item.first;
+        Price bestAskPrice = asks.bestPrice();
 
         return (bestAskPrice <= price); 
     }
@@ -178,32 +251,52 @@ bool OrderBook::canMatch(Side side, double price) const{
         if (bids.empty())
             return false;
 
-        const auto& item = *bids.begin();
-        double bestBidPrice = item.first;
+        Price bestBidPrice = bids.bestPrice();
 
         return (bestBidPrice >= price);
     }
 }
 
 
-Trades OrderBook::matchOrders(){
-    /* Match all possible orders from the orderbook, and return the trades.
+void OrderBook::recordAddLatency(Type type, int key, uint64_t start){
+    if constexpr (INSTRUMENTATION_ENABLED)
+        addLatencies[type][key].record(Timestamp::elapsedNanoseconds(start, Timestamp::stop()));
+}
+
+
+void OrderBook::recordAmendLatency(AmendPath path, int key, uint64_t start){
+    if constexpr (INSTRUMENTATION_ENABLED)
+        amendLatencies[path][key].record(Timestamp::elapsedNanoseconds(start, Timestamp::stop()));
+}
+
+
+void OrderBook::recordCancelLatency(int key, uint64_t start){
+    if constexpr (INSTRUMENTATION_ENABLED)
+        cancelLatencies[key].record(Timestamp::elapsedNanoseconds(start, Timestamp::stop()));
+}
+
+
+void OrderBook::recordMatchLatency(uint64_t start){
+    if constexpr (INSTRUMENTATION_ENABLED)
+        matchLatencies.record(Timestamp::elapsedNanoseconds(start, Timestamp::stop()));
+}
+
+
+template<typename Listener>
+void OrderBook::matchOrders(Side aggressor, ExecutionListener<Listener>& listener){
+    /* Match all possible orders from the orderbook, and report each execution to the listener as it happens.
         Finally, we check if there is any Fill And Kill order that was triggered but not fullt executed to cancel it. 
     */
-    Trades trades;
-
     while (true){
 
         if (bids.empty() || asks.empty())
             break;
 
-        auto& itemBid = *bids.begin();
-        double bestBidPrice = itemBid.first;
-        OrderPointers& bestBids = itemBid.second;
+        Price bestBidPrice = bids.bestPrice();
+        OrderQueue& bestBids = bids.best();
 
-        auto& itemAsk = *asks.begin();
-        double bestAskPrice = itemAsk.first;
-        OrderPointers& bestAsks = itemAsk.second;
+        Price bestAskPrice = asks.bestPrice();
+        OrderQueue& bestAsks = asks.best();
 
         // If the best bid price is less than the best ask price, no match is possible
         if (bestBidPrice < bestAskPrice)
@@ -212,45 +305,43 @@ Trades OrderBook::matchOrders(){
         // Match orders at the best bid & ask prices
         while (!bestBids.empty() && !bestAsks.empty()){
 
-            auto start = std::chrono::high_resolution_clock::now(); // Start of time computation
+            auto start = Timestamp::start(); // Start of time computation
 
-            auto headBid = bestBids.front();
-            auto headAsk = bestAsks.front();
+            Order& headBid = pool[bestBids.front()];   // References (no copy nor refcount) to the orders stored in the pool
+            Order& headAsk = pool[bestAsks.front()];
 
-            uint32_t tradedShares = std::min(headBid->getOrderShares(), headAsk->getOrderShares());
+            uint32_t tradedShares = std::min(headBid.getOrderShares(), headAsk.getOrderShares());
 
             /*  Q: What if order is FOK? We can use canFullyFill(...) to tell if this order should pass or not
                 A: FOK orders that can't be executed are discarded during the add phase    */
             
             // Fill the orders
-            headBid->fillOrder(tradedShares);
-            headAsk->fillOrder(tradedShares);
-
-            // Remove fully filled orders
-            if (headBid->isFilled()){
-                bestBids.pop_front();
-                orders.erase(headBid->getOrderId());
-            }
-
-            if (headAsk->isFilled()){
-                bestAsks.pop_front();
-                orders.erase(headAsk->getOrderId());
-            }
+            headBid.fillOrder(tradedShares);
+            headAsk.fillOrder(tradedShares);
 
-            // Record the trade
-            trades.push_back( Trade( 
-                TradeInfo{headBid->getOrderId(), headBid->getOrderPrice(), tradedShares},
-                TradeInfo{headAsk->getOrderId(), headAsk->getOrderPrice(), tradedShares}
-            ));
+            // Report the execution
+            const Execution execution{headBid.getOrderId(), headAsk.getOrderId(), headBid.getOrderPrice(), headAsk.getOrderPrice(),
+                                        tradedShares, aggressor};
+            listener.execution(execution);
+            recordTrade(execution);
+            eventLog.logTrade(headBid.getOrderId(), headAsk.getOrderId(), tradedShares);
 
             // Update limit level data
-            (void) updateLimitLevelData(headBid->getOrderPrice(), tradedShares, headBid->isFilled() ? Action::Remove : Action::Match);
-            (void) updateLimitLevelData(headAsk->getOrderPrice(), tradedShares, headAsk->isFilled() ? Action::Remove : Action::Match);
+            (void) updateLimitLevelData(Side::Bid, headBid.getOrderPrice(), tradedShares, headBid.isFilled() ? Action::Remove : Action::Match);
+            (void) updateLimitLevelData(Side::Ask, headAsk.getOrderPrice(), tradedShares, headAsk.isFilled() ? Action::Remove : Action::Match);
 
-            auto end = std::chrono::high_resolution_clock::now(); // End of time computation
-            std::chrono::duration<double, std::micro> latency = end - start;
+            // Remove fully filled orders (their slot is released last as headBid/headAsk reference it)
+            if (headBid.isFilled()){
+                orders.erase(headBid.getOrderId());
+                pool.release(bestBids.popFront(pool));
+            }
+
+            if (headAsk.isFilled()){
+                orders.erase(headAsk.getOrderId());
+                pool.release(bestAsks.popFront(pool));
+            }
 
-            matchLatencies.push_back(latency.count());
+            recordMatchLatency(start);   // End of time computation
         }
 
         // Remove empty price levels
@@ -267,35 +358,32 @@ Trades OrderBook::matchOrders(){
 
     // Handle FAK orders
     if (!bids.empty()){
-        auto& item = *bids.begin();
-        OrderPointers& bestBids = item.second;
-        auto headOrder = bestBids.front();
-        if (headOrder->getOrderType() == Type::FAK && headOrder->getOrderInitialShares() != headOrder->getOrderShares())
-            cancelOrder(headOrder->getOrderId(), false); // lock is off since lock is activated before we start matching
+        const Order& headOrder = pool[bids.best().front()];
+        if (headOrder.getOrderType() == Type::FAK && headOrder.getOrderInitialShares() != headOrder.getOrderShares()){
+            auto start = Timestamp::start();
+            recordCancelLatency(removeOrder(headOrder.getOrderId(), bids.best().front()), start);   // Not a command, thus not journaled
+        }
     }
 
     if (!asks.empty()){
-        auto& item = *asks.begin();
-        OrderPointers& bestAsks = item.second;
-        auto headOrder = bestAsks.front();
-        if (headOrder->getOrderType() == Type::FAK && headOrder->getOrderInitialShares() != headOrder->getOrderShares())
-            cancelOrder(headOrder->getOrderId(), false); // lock is off since lock is activated before we start matching
+        const Order& headOrder = pool[asks.best().front()];
+        if (headOrder.getOrderType() == Type::FAK && headOrder.getOrderInitialShares() != headOrder.getOrderShares()){
+            auto start = Timestamp::start();
+            recordCancelLatency(removeOrder(headOrder.getOrderId(), asks.best().front()), start);   // Not a command, thus not journaled
+        }
     }
-
-    // Print trades
-    std::cout << "Trades:" << std::endl;
-    for (const auto& trade : trades)
-        trade.getTradeDetails();
-
-    return trades;
 }
 
 
-OrderBook::OrderBook() {
-    ordersPruneThread = std::thread([this] {
-                                                cancelGFDOrders();
-                                            }
-                                    );
+OrderBook::OrderBook(size_t expectedOrders, LogVerbosity verbosity, bool pruneExpiredOrders, WallClock& _clock)
+: orders(expectedOrders), pool(expectedOrders), clock(_clock), sessionStart(toExpiryTime(_clock.now())),
+  sessionClose(toExpiryTime(nextMarketClose(_clock.now()))),
+  timedOrders(toExpiryTime(_clock.now())), eventLog(verbosity) {
+    if (pruneExpiredOrders)
+        ordersPruneThread = std::thread([this] {
+                                                    pruneOrders();
+                                                }
+                                        );
 }
 
 OrderBook::~OrderBook(){
@@ -311,124 +399,307 @@ OrderBook::~OrderBook(){
 }
 
 
-uint32_t OrderBook::getRandomOrderId(){
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, orders.size() - 1);
-    
-    auto it = orders.begin();
-    std::advance(it, dis(gen)); // Move to a random position in the map
-    return it->first;
+const Order* OrderBook::findOrder(uint32_t orderId) const{
+    const OrderInfo* info = orders.find(orderId);
+    return (info == nullptr) ? nullptr : &pool[info->orderIndex];
 }
 
 
-Trades OrderBook::addOrder(OrderPointer orderPtr, bool newOrder, double initLatencyCount){
-    /*  Given an order pointer we do the following:
-            1. If the order is Fill And/Or Kill, then we first check if it's possible to fill it partially/completely
-            2. If the order is a Market order then we  turn it into a Good Till Cancel order with the worst possible price to make sure
-                it will be fully filled except if the number of shares from the opposite side isn't enough
-        Then we add the order to orders map and given order's side to bids or asks map
+template<typename Listener>
+void OrderBook::placeOrder(Order order, uint64_t start, ExecutionListener<Listener>& listener){
+    /*  Given an order we do the following:
+            1. If the order is Fill And/Or Kill, then we first check if it's possible to fill it partially/completely,
+                and a Good Till Time order is rejected if its expiry time has already passed
+            2. If the order is a Market order then it sweeps the opposite side directly (see sweepMarketOrder), and what's left
+                rests as a Good Till Cancel order at the last traded price
+        Then we copy the order into the pool, add it to orders map and given order's side to bids or asks map
         After that, we update the limit level.
-        Finally we match orders. 
+        Finally we match orders, only if the order crosses the book (it was not crossed before).
+        The caller holds the lock, start is the Timestamp::start() of the request.
+        An order passing the checks is journaled (if a journal is attached) with the time that decided its expiry checks.
     */
-    auto start = std::chrono::high_resolution_clock::now();
+    eventLog.logOrder(EventType::AddOrder, order);
 
-    std::unique_lock<std::mutex> ordersLock{_mutex};
+    // The clock is only read when the order expires or is journaled
+    const bool expires = order.getOrderType() == Type::GFD || order.getOrderType() == Type::GTT;
+    const auto now = (expires || journal != nullptr) ? clock.now() : std::chrono::system_clock::time_point{};
 
-    if (newOrder)
-        std::cout << "Adding Order: ID " << orderPtr->getOrderId()
-                << ", Side " << map_sides[orderPtr->getOrderSide()]
-                << " & Type " << map_types[orderPtr->getOrderType()]
-                << ", Price = " << orderPtr->getOrderPrice()
-                << ", Shares = " << orderPtr->getOrderShares() << std::endl;
-    else
-        std::cout << "Modifying Order of ID " << orderPtr->getOrderId()
-                << ", Side " << map_sides[orderPtr->getOrderSide()]
-                << " & Type " << map_types[orderPtr->getOrderType()]
-                << ": Price = " << orderPtr->getOrderPrice()
-                << ", Shares = " << orderPtr->getOrderShares() << std::endl;
-
-    if (orders.find(orderPtr->getOrderId()) != orders.end()){
-        std::cout << "Order ID " << orderPtr->getOrderId() << " already exists. Skipping." << std::endl;
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::micro> latency = end - start;
-        addLatencies[orderPtr->getOrderType()][0].push_back(latency.count()); // 0 is the default key
-        return {};  // equivalent of None for the return type (Trades in this case)
+    if (orders.contains(order.getOrderId())){
+        eventLog.logReject(order.getOrderId(), RejectReason::DuplicateId);
+        recordAddLatency(order.getOrderType(), 0, start); // 0 is the default key
+        return;
     }
 
-    if (orderPtr->getOrderType() == Type::FAK && !canMatch(orderPtr->getOrderSide(), orderPtr->getOrderPrice())){
-        std::cout << "FAK order cannot be matched. Skipping." << std::endl;    
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::micro> latency = end - start;
-        addLatencies[orderPtr->getOrderType()][0].push_back(latency.count()); // 0 is the default key
-        return {};
+    if (order.getOrderType() == Type::FAK && !canMatch(order.getOrderSide(), order.getOrderPrice())){
+        eventLog.logReject(order.getOrderId(), RejectReason::FAKCannotMatch);
+        recordAddLatency(order.getOrderType(), 0, start); // 0 is the default key
+        return;
     }
 
-    else if (orderPtr->getOrderType() == Type::FOK && !canFullyFill(orderPtr->getOrderSide(), orderPtr->getOrderPrice(), orderPtr->getOrderShares())){
-        std::cout << "FOK order cannot be fully filled. Skipping." << std::endl;
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::micro> latency = end - start;
-        addLatencies[orderPtr->getOrderType()][0].push_back(latency.count()); // 0 is the default key
-        return {};
+    else if (order.getOrderType() == Type::FOK && !canFullyFill(order.getOrderSide(), order.getOrderPrice(), order.getOrderShares())){
+        eventLog.logReject(order.getOrderId(), RejectReason::FOKCannotFill);
+        recordAddLatency(order.getOrderType(), 0, start); // 0 is the default key
+        return;
     }
 
-    else if (orderPtr->getOrderType() == Type::M){  // Market order
-        /* Turn the market order into a Good Till Cancel order with the "worst" possible price, thus we are sure all orders
-            from the opposite side match our order */
-        if (orderPtr->getOrderSide() == Side::Bid && !asks.empty()){
-            const auto& item = *asks.rbegin();
-            double worstAskPrice = item.first;
-            orderPtr->marketToGTC(worstAskPrice);
-        }
-        else if (orderPtr->getOrderSide() == Side::Ask && !bids.empty()) {
-            const auto& item = *bids.rbegin();
-            double worstBidPrice = item.first;
-            orderPtr->marketToGTC(worstBidPrice);
-        }
-        else{
-            std::cout << "Market order cannot be processed. Skipping." << std::endl;
-            auto end = std::chrono::high_resolution_clock::now();
-            std::chrono::duration<double, std::micro> latency = end - start;
-            addLatencies[orderPtr->getOrderType()][0].push_back(latency.count()); // 0 is the default key
-            return {};
-        }
+    else if (order.getOrderType() == Type::GTT && order.getOrderExpiry() <= toExpiryTime(now)){
+        eventLog.logReject(order.getOrderId(), RejectReason::Expired);
+        recordAddLatency(order.getOrderType(), 0, start); // 0 is the default key
+        return;
+    }
+
+    if (journal != nullptr)
+        journal->append(JournalRecord::add(order, now));
+
+    if (order.getOrderType() == Type::M){  // Market order
+        sweepMarketOrder(order, 0, MarketLeftover::Rest, start, listener);
+        return;
     }
 
-    OrderPointers::iterator iterator;
+    // The opposite side doesn't change when inserting the order, thus we know upfront whether it has to be matched
+    const bool crosses = canMatch(order.getOrderSide(), order.getOrderPrice());
+
+    auto addLatenciesKey = restOrder(order, now);
+
+    recordAddLatency(order.getOrderType(), addLatenciesKey, start);
+
+    if (crosses)
+        matchOrders(order.getOrderSide(), listener);
+}
+
+
+int OrderBook::restOrder(const Order& order, std::chrono::system_clock::time_point now){
+    /* Copy the order into the pool, add it to the orders map & to its limit level. Returns the updateLimitLevelData key */
+    PoolIndex orderIndex = pool.allocate(order);
+
+    orders.insert(order.getOrderId(), OrderInfo{orderIndex});
+
+    if (order.getOrderType() == Type::GFD || order.getOrderType() == Type::GTT)
+        scheduleExpiry(pool[orderIndex], now);
+
+    return linkOrder(orderIndex);
+}
+
+
+int OrderBook::linkOrder(PoolIndex orderIndex){
+    const Order& order = pool[orderIndex];
+
+    if (order.getOrderSide() == Side::Bid)
+        bids[order.getOrderPrice()].pushBack(pool, orderIndex);
+    else
+        asks[order.getOrderPrice()].pushBack(pool, orderIndex);
 
-    if (orderPtr->getOrderSide() == Side::Bid){
-        auto& limitLevelOrdersPtrs = bids[orderPtr->getOrderPrice()];
-        limitLevelOrdersPtrs.push_back(orderPtr);
-        iterator = std::prev(limitLevelOrdersPtrs.end());
-        std::cout << "Order added to Bids at price " << orderPtr->getOrderPrice() << std::endl;
+    eventLog.logOrder(EventType::RestOrder, order);
+
+    return updateLimitLevelData(order.getOrderSide(), order.getOrderPrice(), order.getOrderShares(), Action::Add);
+}
+
+
+int OrderBook::unlinkOrder(PoolIndex orderIndex){
+    const Order& order = pool[orderIndex];
+    const auto price = order.getOrderPrice();
+
+    if (order.getOrderSide() == Side::Bid){
+        auto& limitLevelOrders = bids[price];
+        limitLevelOrders.erase(pool, orderIndex);
+
+        if (limitLevelOrders.empty())
+            bids.erase(price);
     }
-    else if (orderPtr->getOrderSide() == Side::Ask){
-        auto& limitLevelOrdersPtrs = asks[orderPtr->getOrderPrice()];
-        limitLevelOrdersPtrs.push_back(orderPtr);
-        iterator = std::prev(limitLevelOrdersPtrs.end());
-        std::cout << "Order added to Asks at price " << orderPtr->getOrderPrice() << std::endl;
+    else{
+        auto& limitLevelOrders = asks[price];
+        limitLevelOrders.erase(pool, orderIndex);
+
+        if (limitLevelOrders.empty())
+            asks.erase(price);
     }
-    else {
-        std::cerr << "Invalid order side. Skipping order." << std::endl;
-        return {};
+
+    return updateLimitLevelData(order.getOrderSide(), price, order.getOrderShares(), Action::Remove);
+}
+
+
+template<typename Listener>
+void OrderBook::sweepMarketOrder(Order order, Price protectionPrice, MarketLeftover leftover, uint64_t start, ExecutionListener<Listener>& listener){
+    /*  Consume the opposite side from its best level, without inserting the market order into the book first: the order
+        only touches the pool, the orders map and the level data if it has shares left and the leftover policy is Rest.
+        The sweep stops at the first level beyond protectionPrice (if not 0). The leftover either rests as a Good Till Cancel
+        order at protectionPrice (or the last traded price without protection), or is cancelled.
+        The caller holds the lock and checked that the order ID isn't already used.   */
+    const Side side = order.getOrderSide();
+
+    auto beyondProtection = [&](Price levelPrice){
+        return protectionPrice != 0 && ((side == Side::Bid) ? levelPrice > protectionPrice : levelPrice < protectionPrice);
+    };
+
+    if ((side == Side::Bid) ? (asks.empty() || beyondProtection(asks.bestPrice())) : (bids.empty() || beyondProtection(bids.bestPrice()))){
+        eventLog.logReject(order.getOrderId(), RejectReason::MarketCannotFill);
+        recordAddLatency(Type::M, 0, start); // 0 is the default key
+        return;
     }
 
-    orders.insert({orderPtr->getOrderId(), OrderInfo{orderPtr, iterator}});
+    Price lastPrice = 0;
+
+    auto sweep = [&](auto& levels, Side restingSide){
+        while (!order.isFilled() && !levels.empty()){
+            const Price levelPrice = levels.bestPrice();
+            if (beyondProtection(levelPrice))
+                break;
+
+            OrderQueue& queue = levels.best();
+
+            while (!order.isFilled() && !queue.empty()){
+                auto matchStart = Timestamp::start();
 
-    auto addLatenciesKey = updateLimitLevelData(orderPtr->getOrderPrice(), orderPtr->getOrderShares(), Action::Add);
+                Order& resting = pool[queue.front()];
+                uint32_t tradedShares = std::min(order.getOrderShares(), resting.getOrderShares());
+
+                order.fillOrder(tradedShares);
+                resting.fillOrder(tradedShares);
+
+                // The market order trades at the resting order's price
+                const Execution execution = (side == Side::Bid)
+                                            ? Execution{order.getOrderId(), resting.getOrderId(), levelPrice, levelPrice, tradedShares, side}
+                                            : Execution{resting.getOrderId(), order.getOrderId(), levelPrice, levelPrice, tradedShares, side};
+                listener.execution(execution);
+                recordTrade(execution);
+                eventLog.logTrade(execution.bidOrderId, execution.askOrderId, tradedShares);
+
+                (void) updateLimitLevelData(restingSide, levelPrice, tradedShares, resting.isFilled() ? Action::Remove : Action::Match);
+
+                if (resting.isFilled()){
+                    orders.erase(resting.getOrderId());
+                    pool.release(queue.popFront(pool));
+                }
+
+                recordMatchLatency(matchStart);
+            }
+
+            if (queue.empty())
+                levels.erase(levelPrice);
+
+            lastPrice = levelPrice;
+        }
+    };
 
-    if (newOrder){
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::micro> latency = end - start;
-        addLatencies[orderPtr->getOrderType()][addLatenciesKey].push_back(latency.count());
+    if (side == Side::Bid)
+        sweep(asks, Side::Ask);
+    else
+        sweep(bids, Side::Bid);
+
+    int addLatenciesKey = 0;
+    if (!order.isFilled() && leftover == MarketLeftover::Rest){
+        // Nothing left on the opposite side up to the rest price, thus the leftover can't cross the book
+        order.marketToGTC((protectionPrice != 0) ? protectionPrice : lastPrice);
+        addLatenciesKey = restOrder(order, {});   // A GTC order, which doesn't expire
     }
-    else{
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::micro> latency = end - start;
-        amendLatencies[addLatenciesKey].push_back(initLatencyCount + latency.count()); // amendLatenciesKey not add...
+
+    recordAddLatency(Type::M, addLatenciesKey, start);
+}
+
+
+template<typename Listener>
+void OrderBook::addMarketOrder(Order order, Price protectionPrice, MarketLeftover leftover, ExecutionListener<Listener>& listener){
+    auto start = Timestamp::start();
+
+    if (order.getOrderType() != Type::M)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << order.getOrderId() << ") should be a market order to be swept").str()
+        );
+
+    if (protectionPrice < 0)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "Order (" << order.getOrderId() << ") can't have a negative protection price").str()
+        );
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    eventLog.logOrder(EventType::AddOrder, order);
+
+    if (orders.contains(order.getOrderId())){
+        eventLog.logReject(order.getOrderId(), RejectReason::DuplicateId);
+        recordAddLatency(order.getOrderType(), 0, start); // 0 is the default key
+        return;
+    }
+
+    if (journal != nullptr)
+        journal->append(JournalRecord::add(order, clock.now(), protectionPrice, leftover));
+
+    sweepMarketOrder(order, protectionPrice, leftover, start, listener);
+    publishView();
+}
+
+
+template<typename Listener>
+void OrderBook::addOrder(Order order, ExecutionListener<Listener>& listener){
+    auto start = Timestamp::start();
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    placeOrder(order, start, listener);
+    publishView();
+}
+
+
+Trades OrderBook::addOrder(Order order){
+    auto start = Timestamp::start();
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    Trades trades;
+    TradesCollector collector(trades);
+    placeOrder(order, start, collector);
+    publishView();
+    return trades;
+}
+
+
+template<typename Listener>
+void OrderBook::addOrders(const Order* newOrders, size_t nOrders, ExecutionListener<Listener>& listener){
+    /* Add a batch of orders under a single lock, reporting the executions to listener */
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    for (size_t i = 0; i < nOrders; ++i)
+        placeOrder(newOrders[i], Timestamp::start(), listener);
+
+    publishView();  // Once per batch
+}
+
+
+void OrderBook::addOrders(const Order* newOrders, size_t nOrders, Trades& trades){
+    TradesCollector collector(trades);
+    addOrders(newOrders, nOrders, collector);
+}
+
+
+template<typename Listener>
+void OrderBook::applyCommands(const OrderCommand* commands, size_t nCommands, ExecutionListener<Listener>& listener){
+    /* Apply a batch of add/cancel/amend commands in order under a single lock, reporting the executions to listener.
+       If a command is invalid the exception propagates (as with the single order API) and the previous commands remain applied. */
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    for (size_t i = 0; i < nCommands; ++i){
+        const OrderCommand& command = commands[i];
+
+        switch (command.command){
+            case CommandType::Add:
+                placeOrder(command.toOrder(), Timestamp::start(), listener);
+                break;
+            case CommandType::Cancel:
+                cancelOrder(command.orderId, false);
+                break;
+            case CommandType::Amend:
+                replaceOrder(command.orderId, command.price, command.shares, Timestamp::start(), listener);
+                break;
+        }
     }
 
-    return matchOrders();
+    publishView();  // Once per batch
+}
+
+
+void OrderBook::applyCommands(const OrderCommand* commands, size_t nCommands, Trades& trades){
+    TradesCollector collector(trades);
+    applyCommands(commands, nCommands, collector);
 }
 
 
@@ -439,111 +710,328 @@ void OrderBook::cancelOrder(uint32_t orderId, bool lockOn, bool amendedOrder){
         
     This function cancels an order by removing it from orders map, then asks or bids map given its side, and finally updates its limit level.
     */
-    auto start = std::chrono::high_resolution_clock::now();
+    auto start = Timestamp::start();
 
+    // The lock must outlive the if statement, thus it's only acquired (not constructed) conditionally
+    std::unique_lock<std::mutex> ordersLock{_mutex, std::defer_lock};
     if (lockOn)
-        std::unique_lock<std::mutex> ordersLock{_mutex};    
+        ordersLock.lock();
 
-    if (orders.find(orderId) == orders.end())
+    const OrderInfo* info = orders.find(orderId);
+    if (info == nullptr)
         return;
 
-    const auto& item = orders.at(orderId);
-    OrderPointer orderPtr = item.order;
-    OrderPointers::iterator orderIterator = item.orderIter; 
-    
+    if (journal != nullptr)
+        journal->append(JournalRecord::cancel(orderId, clock.now()));
+
+    auto cancelLatenciesKey = removeOrder(orderId, info->orderIndex);
+
+    if (!amendedOrder)
+        recordCancelLatency(cancelLatenciesKey, start);
+
+    if (lockOn)     // Otherwise the caller's batch or amend publishes
+        publishView();
+}
+
+
+int OrderBook::removeOrder(OrderId orderId, PoolIndex orderIndex){
+    /* The caller holds the lock */
     // Remove order from orders map
     orders.erase(orderId);
 
-    // Remove order from asks or bids given its side
-    const auto price = orderPtr->getOrderPrice();
+    // Remove order from asks or bids given its side, and update its limit level
+    auto cancelLatenciesKey = unlinkOrder(orderIndex);
 
-    if (orderPtr->getOrderSide() == Side::Bid){
-        bids[price].erase(orderIterator);
+    // Give the order's slot back to the pool
+    pool.release(orderIndex);
 
-        if (bids[price].empty())
-            bids.erase(price);
-    }
-    else{
-        asks[price].erase(orderIterator);
+    return cancelLatenciesKey;
+}
 
-        if (asks[price].empty())
-            asks.erase(price);
-    }
 
-    // Update order's limit level
-    auto cancelLatenciesKey = updateLimitLevelData(orderPtr->getOrderPrice(), orderPtr->getOrderShares(), Action::Remove);
+void OrderBook::attachJournal(JournalWriter* _journal){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+    journal = _journal;
+}
+
 
-    if (!amendedOrder){
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double, std::micro> latency = end - start;
-        cancelLatencies[cancelLatenciesKey].push_back(latency.count());
-    }
+void OrderBook::attachView(BookView* _view){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+    view = _view;
+
+    // The first publication collects both sides
+    bidView.invalidate();
+    askView.invalidate();
+    viewChanged = true;
+    publishView();
 }
 
 
-Trades OrderBook::amendOrder(OrderPointer existingOrderPtr, double newPrice, uint32_t newShares){
-    auto start = std::chrono::high_resolution_clock::now();
+void OrderBook::publishView(){
+    /*  Nothing is published if neither the viewed levels nor the trades changed (e.g. a rejected order, a change deep in the book).
+        A stale side is collected again from the limit level data.   */
+    if (view == nullptr || (!viewChanged && viewSnapshot.nTrades == nTrades))
+        return;
 
-    if (newPrice < 0)
+    auto levelsOf = [](const auto& levels, const std::unordered_map<Price, LimitLevelData>& data){
+        return [&](auto&& function){
+            levels.forEachLevel([&](Price price, const OrderQueue&){
+                const LimitLevelData& level = data.at(price);
+                return function(LimitLevelInfo{price, level.totalShares, level.totalOrders});
+            });
+        };
+    };
+
+    if (bidView.isStale())
+        bidView.collect(levelsOf(bids, bidData));
+    if (askView.isStale())
+        askView.collect(levelsOf(asks, askData));
+    viewChanged = false;
+
+    viewSnapshot.sequence = marketData.getSequence();
+    viewSnapshot.nTrades = nTrades;
+    viewSnapshot.lastTrade = lastTrade;
+    viewSnapshot.nBids = bidView.copyView(viewSnapshot.bids);
+    viewSnapshot.nAsks = askView.copyView(viewSnapshot.asks);
+    view->publish(viewSnapshot);
+}
+
+
+template<typename Listener>
+void OrderBook::replaceOrder(uint32_t orderId, Price newPrice, uint32_t newShares, uint64_t start, ExecutionListener<Listener>& listener){
+    /*  Modify the order where it is stored, it is never cancelled nor added back:
+            - same price & fewer (or as many) shares: the size is reduced in place, the order keeps its time priority
+            - otherwise: the order is moved to the back of its new limit level (it loses its time priority),
+                and matched if it now crosses the book
+        The caller holds the lock, thus the order can't be executed while it is being modified.   */
+    if (newPrice <= 0)
         throw std::logic_error(
-            (std::ostringstream{} << "Order (" << existingOrderPtr->getOrderId() << ") can't be modified as the new price is negative").str()
+            (std::ostringstream{} << "Order (" << orderId << ") can't be modified as the new price should be strictly positive").str()
         );
 
     if (newShares <= 0)
         throw std::logic_error(
-            (std::ostringstream{} << "Order (" << existingOrderPtr->getOrderId() << ") can't be modified as the new number of shares should be strictly positive").str()
+            (std::ostringstream{} << "Order (" << orderId << ") can't be modified as the new number of shares should be strictly positive").str()
         );
 
-    {   // Use lock to avoid executing this order while it is being modified
-        std::unique_lock<std::mutex> lock{_mutex};
+    const OrderInfo* info = orders.find(orderId);
+    if (info == nullptr){
+        eventLog.logReject(orderId, RejectReason::UnknownOrder);
+        return;
+    }
+
+    if (journal != nullptr)
+        journal->append(JournalRecord::amend(orderId, newPrice, newShares, clock.now()));
 
-        Type orderType = existingOrderPtr->getOrderType();
-        
-        if (orders.find(existingOrderPtr->getOrderId()) == orders.end()){
-            std::cout << "Inexistent order. Can't be modified." << std::endl;
-            return {};
-        }
+    const PoolIndex orderIndex = info->orderIndex;
+    Order& order = pool[orderIndex];
+
+    if (newPrice == order.getOrderPrice() && newShares <= order.getOrderShares()){  // In place
+        const uint32_t removedShares = order.getOrderShares() - newShares;
+        order.reduceShares(newShares);
+        eventLog.logOrder(EventType::ModifyOrder, order);
 
-        cancelOrder(existingOrderPtr->getOrderId(), false, true);
+        if (removedShares != 0)
+            (void) updateLimitLevelData(order.getOrderSide(), newPrice, removedShares, Action::Reduce);
+
+        recordAmendLatency(AmendPath::InPlace, 0, start);   // The order stays in its limit level
+        return;
     }
 
-    auto newOrderPtr = std::make_shared<Order> (
-        existingOrderPtr->getOrderId(), existingOrderPtr->getOrderType(), existingOrderPtr->getOrderSide(), newPrice, newShares
-    );
+    // Move: the order keeps its pool slot & its entry in the orders map
+    (void) unlinkOrder(orderIndex);
+    order.modify(newPrice, newShares);
+    eventLog.logOrder(EventType::ModifyOrder, order);
+
+    const bool crosses = canMatch(order.getOrderSide(), newPrice);
+    const Side side = order.getOrderSide();
+
+    auto amendLatenciesKey = linkOrder(orderIndex);
+    recordAmendLatency(AmendPath::Move, amendLatenciesKey, start);
+
+    if (crosses)
+        matchOrders(side, listener);
+}
+
+
+template<typename Listener>
+void OrderBook::amendOrder(uint32_t orderId, Price newPrice, uint32_t newShares, ExecutionListener<Listener>& listener){
+    auto start = Timestamp::start();
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    replaceOrder(orderId, newPrice, newShares, start, listener);
+    publishView();
+}
+
+
+Trades OrderBook::amendOrder(uint32_t orderId, Price newPrice, uint32_t newShares){
+    auto start = Timestamp::start();
+
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    Trades trades;
+    TradesCollector collector(trades);
+    replaceOrder(orderId, newPrice, newShares, start, collector);
+    publishView();
+    return trades;
+}
+
+
+LimitLevelInfo OrderBook::bestLevel(Side side) const{
+    if (side == Side::Bid){
+        if (bids.empty())
+            return LimitLevelInfo{0, 0, 0};
+
+        const Price price = bids.bestPrice();
+        const LimitLevelData& level = bidData.at(price);
+        return LimitLevelInfo{price, level.totalShares, level.totalOrders};
+    }
+    else{
+        if (asks.empty())
+            return LimitLevelInfo{0, 0, 0};
+
+        const Price price = asks.bestPrice();
+        const LimitLevelData& level = askData.at(price);
+        return LimitLevelInfo{price, level.totalShares, level.totalOrders};
+    }
+}
+
+
+LimitLevelInfo OrderBook::getBestBid(){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    return bestLevel(Side::Bid);
+}
+
+
+LimitLevelInfo OrderBook::getBestAsk(){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    return bestLevel(Side::Ask);
+}
+
+
+LimitLevel OrderBook::getTopOfBook(){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    return LimitLevel(bestLevel(Side::Bid), bestLevel(Side::Ask));
+}
+
+
+size_t OrderBook::getDepth(Side side, size_t nLevels, LimitLevelInfos& levels){
+    /* Only the first nLevels levels are visited, and levels keeps its capacity from one call to the next */
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    levels.clear();
+    if (nLevels == 0)
+        return 0;
+
+    auto collect = [&](const std::unordered_map<Price, LimitLevelData>& data){
+        return [&](Price price, const OrderQueue&){
+            const LimitLevelData& level = data.at(price);
+            levels.push_back(LimitLevelInfo{price, level.totalShares, level.totalOrders});
+            return levels.size() < nLevels;
+        };
+    };
+
+    if (side == Side::Bid)
+        bids.forEachLevel(collect(bidData));
+    else
+        asks.forEachLevel(collect(askData));
+
+    return levels.size();
+}
+
+
+Price OrderBook::getSpread(){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    if (bids.empty() || asks.empty())
+        return 0;
+    return asks.bestPrice() - bids.bestPrice();
+}
+
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double, std::micro> initLatency = end - start;
+double OrderBook::getMidPrice(){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
 
-    return addOrder(newOrderPtr, false, initLatency.count());
+    if (bids.empty() || asks.empty())
+        return 0.0;
+    return toDecimalPrice(asks.bestPrice() + bids.bestPrice()) / 2;
+}
+
+
+BookSnapshot OrderBook::takeSnapshot() const{
+    /* Levels are read from the limit level data, from the best to the worst price, thus the orders aren't scanned.
+       The caller holds the lock. */
+    BookSnapshot snapshot;
+    snapshot.sequence = marketData.getSequence();
+
+    bids.forEachLevel([&](Price price, const OrderQueue&){
+        const LimitLevelData& level = bidData.at(price);
+        snapshot.bids.push_back(LimitLevelInfo{price, level.totalShares, level.totalOrders});
+        return true;
+    });
+
+    asks.forEachLevel([&](Price price, const OrderQueue&){
+        const LimitLevelData& level = askData.at(price);
+        snapshot.asks.push_back(LimitLevelInfo{price, level.totalShares, level.totalOrders});
+        return true;
+    });
+
+    return snapshot;
+}
+
+
+BookSnapshot OrderBook::getSnapshot(){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    return takeSnapshot();
+}
+
+
+MarketDataSubscription OrderBook::subscribeMarketData(LevelUpdateHandler handler){
+    /* The snapshot is taken under the same lock as the subscription: the handler receives the updates following it, with no gap */
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    MarketDataSubscription subscription;
+    subscription.snapshot = takeSnapshot();
+    subscription.id = marketData.subscribe(std::move(handler));
+    return subscription;
+}
+
+
+void OrderBook::unsubscribeMarketData(SubscriptionId id){
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+
+    marketData.unsubscribe(id);
 }
 
 
 void OrderBook::printOrderBook() const{
+    eventLog.flush();   // Make sure pending events are written before the book
+
+    // The totals of each level are kept up to date by updateLimitLevelData, thus the orders aren't summed again
+    std::unique_lock<std::mutex> ordersLock{_mutex};
+    const BookSnapshot snapshot = takeSnapshot();
+    ordersLock.unlock();
+
     std::cout << "Order Book:" << std::endl;
 
     // Print Bids
     std::cout << "Bids:" << std::endl;
-    for (const auto& price_bidPtr : bids){ // [price, vector of Bids of this price]
-        uint32_t totalShares = 0;
-        for (const auto& orderPtr : price_bidPtr.second)
-            totalShares += orderPtr->getOrderShares();
-
-        std::cout   << "  Price = " << price_bidPtr.first 
-                    << ", Number of Bids = " << price_bidPtr.second.size() 
-                    << ", Number of Shares = " << totalShares << std::endl;
-    }
+    for (const auto& level : snapshot.bids)
+        std::cout   << "  Price = " << toDecimalPrice(level.price) 
+                    << ", Number of Bids = " << level.totalOrders 
+                    << ", Number of Shares = " << level.totalShares << std::endl;
                 
     // Print Asks
     std::cout << "Asks:" << std::endl;
-    for (const auto& price_askPtr : asks){ // [price, vector of Asks of this price]
-        uint32_t totalShares = 0;
-        for (const auto& orderPtr : price_askPtr.second)
-            totalShares += orderPtr->getOrderShares();
-
-        std::cout   << "  Price = " << price_askPtr.first 
-                    << ", Number of Asks = " << price_askPtr.second.size() 
-                    << ", Number of Shares = " << totalShares << std::endl;
-    }
+    for (const auto& level : snapshot.asks)
+        std::cout   << "  Price = " << toDecimalPrice(level.price) 
+                    << ", Number of Asks = " << level.totalOrders 
+                    << ", Number of Shares = " << level.totalShares << std::endl;
 }
 
 
@@ -555,93 +1043,168 @@ void OrderBook::clearLatencies(){
 }
 
 
-void OrderBook::writeLatencyStatsToFile(const std::string& filename, int nUpdates){
-    std::ofstream file(filename);
-    if (!file.is_open())
-        throw std::runtime_error("Failed to open file for writing latency statistics.");
+template<typename Key>
+static void copyHistograms(const std::unordered_map<Key, LatencyHistogram>& from, std::unordered_map<Key, LatencyHistogram>& to){
+    /* Copy into the histograms to already has, thus only new keys allocate. Those gone from from (clearLatencies) are emptied */
+    for (auto& [key, histogram] : to)
+        if (from.find(key) == from.end())
+            histogram.clear();
 
-    int totalTransactions = 0;
+    for (const auto& [key, histogram] : from)
+        to[key] = histogram;
+}
 
-    auto computeStats = [](const std::vector<double>& latencies) -> std::pair<double, double> {
-        if (latencies.empty()) 
-            return {0.0, 0.0};
 
-        double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
-        double variance = 0.0;
-        for (double latency : latencies)
-            variance += (latency - mean) * (latency - mean);
-        variance /= latencies.size();
-        
-        return {mean, variance};
+template<typename Key>
+static void copyHistograms(const std::unordered_map<Key, std::unordered_map<int, LatencyHistogram>>& from,
+                            std::unordered_map<Key, std::unordered_map<int, LatencyHistogram>>& to){
+    for (auto& [key, histograms] : to)
+        if (from.find(key) == from.end())
+            for (auto& entry : histograms)
+                entry.second.clear();
+
+    for (const auto& [key, histograms] : from)
+        copyHistograms(histograms, to[key]);
+}
+
+
+void OrderBook::copyLatencyStats(LatencyStats& stats){
+    std::lock_guard<std::mutex> ordersLock{_mutex};
+    copyHistograms(addLatencies, stats.addLatencies);
+    copyHistograms(amendLatencies, stats.amendLatencies);
+    copyHistograms(cancelLatencies, stats.cancelLatencies);
+    stats.matchLatencies = matchLatencies;
+    stats.orderIndexMemory = orders.bytesReserved();
+    stats.liveOrders = pool.size();
+    stats.poolCapacity = pool.capacity();
+    stats.poolMemory = pool.bytesReserved();
+}
+
+
+std::string OrderBook::formatLatencyStats(const LatencyStats& stats){
+    int totalTransactions;
+    return formatLatencyStats(stats, totalTransactions);
+}
+
+
+std::string OrderBook::formatLatencyStats(const LatencyStats& stats, int& totalTransactions){
+    /* The percentiles & the JSON are computed from the copy, without the lock. Emptied histograms (see copyHistograms) are skipped */
+    totalTransactions = 0;
+
+    auto computeStats = [](const LatencyHistogram& latencies) -> json {
+        /* Mean, variance and percentiles of the given latencies, in microseconds (they are recorded in nanoseconds) */
+        auto toMicros = [](double nanoseconds) {return nanoseconds / 1e3;};
+
+        return {
+            {"mean_latency (μs)", toMicros(latencies.mean())},
+            {"latency_variance (μs)", latencies.variance() / 1e6},
+            {"p50_latency (μs)", toMicros(latencies.percentile(50.0))},
+            {"p90_latency (μs)", toMicros(latencies.percentile(90.0))},
+            {"p99_latency (μs)", toMicros(latencies.percentile(99.0))},
+            {"p99.9_latency (μs)", toMicros(latencies.percentile(99.9))},
+            {"p99.99_latency (μs)", toMicros(latencies.percentile(99.99))},
+            {"max_latency (μs)", toMicros(latencies.max())},
+            {"number_of_orders", latencies.count()}
+        };
     };
 
     json statsJson;
 
+    statsJson["price_levels_backend"] = PRICE_LEVELS_BACKEND;
+    statsJson["timestamp_source"] = Timestamp::source();
+
     // Add Order Latencies
-    for (const auto& type_addLatency : addLatencies){
-        const auto& orderTypeStr = map_types[type_addLatency.first];
+    for (const auto& type_addLatency : stats.addLatencies){
+        const std::string orderTypeStr = toString(type_addLatency.first);
 
         for (const auto& addLatency : type_addLatency.second){
+            if (addLatency.second.count() == 0)
+                continue;
             std::string limitStatusStr = (addLatency.first == 0) ? "existing_limit_level" : "new_limit_level";
-            auto addStats = computeStats(addLatency.second);
-
-            statsJson["Add"].push_back({
-                {"order_type", orderTypeStr},
-                {"limit_level_status", limitStatusStr},
-                {"mean_latency (μs)", addStats.first},
-                {"latency_variance (μs)", addStats.second},
-                {"number_of_orders", addLatency.second.size()}
-            });
 
-            totalTransactions += addLatency.second.size();
+            json addStats = computeStats(addLatency.second);
+            addStats["order_type"] = orderTypeStr;
+            addStats["limit_level_status"] = limitStatusStr;
+            statsJson["Add"].push_back(addStats);
+
+            totalTransactions += addLatency.second.count();
         }
     }
 
-    // Amend Order Latencies
-    for (const auto& amendLatency : amendLatencies){
-        std::string limitStatusStr = (amendLatency.first == 0) ? "existing_limit_level" : "new_limit_level";
-        auto amendStats = computeStats(amendLatency.second);
+    // Amend Order Latencies, per amend path
+    for (const auto& path_amendLatency : stats.amendLatencies){
+        const std::string amendPathStr = toString(path_amendLatency.first);
 
-        statsJson["Amend"].push_back({
-            {"limit_level_status", limitStatusStr},
-            {"mean_latency (μs)", amendStats.first},
-            {"latency_variance (μs)", amendStats.second},
-            {"number_of_orders", amendLatency.second.size()}
-        });
+        for (const auto& amendLatency : path_amendLatency.second){
+            if (amendLatency.second.count() == 0)
+                continue;
+            std::string limitStatusStr = (amendLatency.first == 0) ? "existing_limit_level" : "new_limit_level";
 
-        totalTransactions += amendLatency.second.size();
+            json amendStats = computeStats(amendLatency.second);
+            amendStats["amend_path"] = amendPathStr;
+            amendStats["limit_level_status"] = limitStatusStr;
+            statsJson["Amend"].push_back(amendStats);
+
+            totalTransactions += amendLatency.second.count();
+        }
     }
 
     // Cancel Order Latencies
-    for (const auto& cancelLatency : cancelLatencies){
-        std::string limitStatusStr = (cancelLatency.first == 0) ? "last_in_limit_level" : "not_last_in_limit_level";
-        auto cancelStats = computeStats(cancelLatency.second);
-
-        statsJson["Cancel"].push_back({
-            {"limit_level_status", limitStatusStr},
-            {"mean_latency (μs)", cancelStats.first},
-            {"latency_variance (μs)", cancelStats.second},
-            {"number_of_orders", cancelLatency.second.size()}
-        });
+    for (const auto& cancelLatency : stats.cancelLatencies){
+        if (cancelLatency.second.count() == 0)
+            continue;
+        std::string limitStatusStr = (cancelLatency.first == -1) ? "last_in_limit_level" : "not_last_in_limit_level";
 
-        totalTransactions += cancelLatency.second.size();
+        json cancelStats = computeStats(cancelLatency.second);
+        cancelStats["limit_level_status"] = limitStatusStr;
+        statsJson["Cancel"].push_back(cancelStats);
+
+        totalTransactions += cancelLatency.second.count();
     }
 
     // Match Latencies
-    auto matchStats = computeStats(matchLatencies);
-    statsJson["Match"] = {
-        {"limit_level_status", "none"},
-        {"mean_latency (μs)", matchStats.first},
-        {"latency_variance (μs)", matchStats.second},
-        {"number_of_orders", matchLatencies.size()}
+    statsJson["Match"] = computeStats(stats.matchLatencies);
+    statsJson["Match"]["limit_level_status"] = "none";
+
+    // Memory used to store the resting orders: each order lives in a pool slot which also holds its intrusive links,
+    // and in a flat slot of the orders map, thus there is no separate control block (shared_ptr) nor list/hash node per order
+    statsJson["Memory"] = {
+        {"order_slot_size (bytes)", sizeof(Order)},
+        {"order_index_slot_size (bytes)", decltype(orders)::slotSize()},
+        {"memory_per_order (bytes)", sizeof(Order) + decltype(orders)::slotSize()},
+        {"order_index_memory (bytes)", stats.orderIndexMemory},
+        {"live_orders", stats.liveOrders},
+        {"pool_capacity (orders)", stats.poolCapacity},
+        {"pool_memory (bytes)", stats.poolMemory},
+        {"pool_memory_per_live_order (bytes)", stats.liveOrders ? static_cast<double>(stats.poolMemory) / stats.liveOrders : 0.0}
     };
 
-    // Write to file
-    file << std::setw(4) << statsJson << std::endl;
+    return statsJson.dump(4);
+}
+
+
+std::string OrderBook::getLatencyStats(){
+    LatencyStats stats;
+    copyLatencyStats(stats);
+    return formatLatencyStats(stats);
+}
+
+
+void OrderBook::writeLatencyStatsToFile(const std::string& filename, int nUpdates){
+    std::ofstream file(filename);
+    if (!file.is_open())
+        throw std::runtime_error("Failed to open file for writing latency statistics.");
+
+    LatencyStats stats;
+    copyLatencyStats(stats);
+    int totalTransactions;
+    file << formatLatencyStats(stats, totalTransactions) << std::endl;
 
     // Consistency check
     std::cout << "\nTotal Transactions Counted: " << totalTransactions << " | Minimum Expected: " << nUpdates << "\n";
-    if (nUpdates != -1 && totalTransactions < nUpdates)
+    if (!INSTRUMENTATION_ENABLED)
+        std::cout << "Instrumentation is disabled (ORDERBOOK_NO_INSTRUMENTATION), no latency was recorded" << std::endl;
+    else if (nUpdates != -1 && totalTransactions < nUpdates)
         throw std::runtime_error("Mismatch in total number of updates!");
 
     std::cout << "Latency statistics written to " << filename << std::endl;
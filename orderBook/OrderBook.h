@@ -3,18 +3,35 @@
 #include "enums.h"
 #include "LimitLevel.h"
 #include "Order.h"
+#include "OrderCommand.h"
+#include "OrderPool.h"
+#include "OrderIdMap.h"
+#include "PriceLevels.h"
+#include "CumulativeDepth.h"
+#include "TimerWheel.h"
+#include "WallClock.h"
 #include "Trade.h"
+#include "ExecutionListener.h"
+#include "MarketData.h"
+#include "BookView.h"
+#include "EventLog.h"
+#include "LatencyHistogram.h"
+#include "Timestamp.h"
 
 #include <map>
 #include <unordered_map>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
 #include <random>
 #include <chrono>
 #include <numeric>
 
+class JournalWriter;    // See Journal.h
+
 struct OrderInfo{
-    OrderPointer order{nullptr};
-    OrderPointers::iterator orderIter;  // Used for fast access to the order in OrderPointers = std::list<OrderPointer>
+    PoolIndex orderIndex = NULL_INDEX;  // Used for fast access to the order in the pool, which also gives its position in its limit level
 };
 
 struct LimitLevelData{
@@ -22,59 +39,241 @@ struct LimitLevelData{
     uint32_t totalOrders = 0;
 };
 
+// Copy of the book's latency histograms & memory figures (see OrderBook::copyLatencyStats), formatted without the book
+struct LatencyStats{
+    std::unordered_map<Type, std::unordered_map<int, LatencyHistogram>> addLatencies;
+    std::unordered_map<AmendPath, std::unordered_map<int, LatencyHistogram>> amendLatencies;
+    std::unordered_map<int, LatencyHistogram> cancelLatencies;
+    LatencyHistogram matchLatencies;
+    size_t orderIndexMemory = 0;
+    size_t liveOrders = 0;
+    size_t poolCapacity = 0;
+    size_t poolMemory = 0;
+};
+
 
 class OrderBook{
 private:
-    std::unordered_map<double, LimitLevelData> data; // This map associates to each price its limit level's data
-    std::unordered_map<uint32_t, OrderInfo> orders;
+    // These maps associate to each price its limit level's data, one per side as an incoming order may (briefly) rest at the price of an opposite level
+    std::unordered_map<Price, LimitLevelData> bidData, askData;
+    CumulativeDepth bidDepth, askDepth;  // Cumulative shares over the levels of each side, kept in sync with bidData & askData
+    OrderIdMap<OrderInfo> orders;   // Flat open-addressing map [orderId, OrderInfo], hit on every add/cancel/amend/fill
+    OrderPool pool; // Storage of all resting orders
 
-    // We use map not unordered_map for both bids & asks since limit levels are ordered given their prices
-    std::map<double, OrderPointers, std::greater<>> bids; // [bidPrice, list of orders of price bidPrice]
-    std::map<double, OrderPointers> asks;   // std::less<> is the default comparator thus no need to state it explicitly // [askPrice, list of orders of price askPrice]
+    // Limit levels are ordered given their prices: either a std::map or a price ladder (see PriceLevels.h)
+    PriceLevels<Side::Bid> bids; // [bidPrice, list of orders of price bidPrice], best (highest) price first
+    PriceLevels<Side::Ask> asks; // [askPrice, list of orders of price askPrice], best (lowest) price first
 
-    std::unordered_map<Type, std::unordered_map<int, std::vector<double>>> addLatencies;
-    std::unordered_map<int, std::vector<double>> amendLatencies, cancelLatencies;
+    // Expiry of GFD & GTT orders: the due orders are looked up by expiry time, thus the book is never scanned for them
+    WallClock& clock;   // Read when GFD & GTT orders rest and when they are expired, may be injected (see WallClock.h)
+    ExpiryTime sessionStart;    // Time at which sessionClose was computed, it's the close of every time in [sessionStart, sessionClose)
+    ExpiryTime sessionClose;    // Expiry of the GFD orders resting now (the next market close)
+    std::map<ExpiryTime, std::vector<OrderId>> dayOrders;   // [expiry, GFD orders], a single entry per market close
+    TimerWheel<OrderId> timedOrders;    // GTT orders, by expiry time
+    std::vector<OrderId> expiredOrders; // Due orders not cancelled yet, taken in chunks by expireOrders
+
+    // Latencies are recorded into constant-memory histograms (see LatencyHistogram.h)
+    std::unordered_map<Type, std::unordered_map<int, LatencyHistogram>> addLatencies;
+    std::unordered_map<AmendPath, std::unordered_map<int, LatencyHistogram>> amendLatencies;
+    std::unordered_map<int, LatencyHistogram> cancelLatencies;
     /*  addLatencies keys: 0 -> add order with an existing limit level; 1 -> ... new limit level;
-        amendLatencies keys: same as for addLatencies excpet that we are amending orders
-        cancelLatencies keys: 0 -> if the cancelled order is last in its limit level; 1 -> if not   */
-    std::vector<double> matchLatencies;
+        amendLatencies keys: the amend path (see AmendPath), then same as for addLatencies excpet that we are amending orders
+        cancelLatencies keys: -1 -> if the cancelled order is last in its limit level; 0 -> if not   */
+    LatencyHistogram matchLatencies;
     
     std::thread ordersPruneThread; 
+    static constexpr std::chrono::milliseconds EXPIRY_POLL_INTERVAL{100};  // The clock may be injected & moved at any time, thus it's polled
     std::condition_variable shutdownConditionVariable; 
     std::atomic<bool> shutdown = false;   
     
-    std::mutex _mutex;
+    mutable std::mutex _mutex;  // Also taken by const readers (printOrderBook)
+
+    EventLog eventLog;  // Asynchronous log of orders & trades, keeps console I/O off the matching path
+
+    MarketDataFeed marketData;  // L2 updates published by updateLimitLevelData
+
+    JournalWriter* journal = nullptr;   // Write-ahead journal of the accepted commands, if attached (see Journal.h)
+
+    // Seqlock view for reader threads, if attached (see BookView.h), kept up to date by the level changes
+    BookView* view = nullptr;
+    BookViewSnapshot viewSnapshot;      // Last published
+    BookViewSide<Side::Bid> bidView;
+    BookViewSide<Side::Ask> askView;
+    bool viewChanged = false;           // Since the last publication
+    uint64_t nTrades = 0;
+    LastTrade lastTrade;
+
+    void recordTrade(const Execution& execution){
+        ++nTrades;
+        lastTrade = LastTrade{execution.price(), execution.shares, execution.aggressor};
+    }
+
+    void updateViewLevel(Side side, Price price, uint32_t totalShares, uint32_t totalOrders, LevelAction action){
+        viewChanged = ((side == Side::Bid) ? bidView.apply(price, totalShares, totalOrders, action)
+                                           : askView.apply(price, totalShares, totalOrders, action)) || viewChanged;
+    }
 
-    void cancelGFDOrders(uint32_t TRADING_CLOSE_HOUR = 16);
+    void publishView();     // After each command, the caller holds the lock
 
-    void cancelOrders(std::vector<uint32_t> orderIds);
+    void pruneOrders();  // Body of ordersPruneThread
 
-    int updateLimitLevelData(double price, uint32_t shares, Action action);
+    void scheduleExpiry(Order& order, std::chrono::system_clock::time_point now);  // Index a resting GFD or GTT order by its expiry time
 
-    bool canFullyFill(Side side, double price, uint32_t quantity) const;
+    void collectExpiredOrders(ExpiryTime now);  // Move the orders due at now to expiredOrders
+
+    int updateLimitLevelData(Side side, Price price, uint32_t shares, Action action);
+
+    BookSnapshot takeSnapshot() const;  // The caller holds the lock
+
+    LimitLevelInfo bestLevel(Side side) const;  // The caller holds the lock
+
+    bool canFullyFill(Side side, Price price, uint32_t quantity) const;
     
-    bool canMatch(Side side, double price) const;
+    bool canMatch(Side side, Price price) const;
     
-    Trades matchOrders();
+    // aggressor: side of the order that crossed the book, executions are reported to listener as they happen
+    template<typename Listener>
+    void matchOrders(Side aggressor, ExecutionListener<Listener>& listener);
+
+    // Core of addOrder & amendOrder, the caller holds the lock and provides the listener
+    template<typename Listener>
+    void placeOrder(Order order, uint64_t start, ExecutionListener<Listener>& listener);
+    template<typename Listener>
+    void replaceOrder(uint32_t orderId, Price newPrice, uint32_t newShares, uint64_t start, ExecutionListener<Listener>& listener);
+
+    // Insert an order that doesn't cross the book, returns the updateLimitLevelData key. now: time of the request, which sets the expiry of GFD orders
+    int restOrder(const Order& order, std::chrono::system_clock::time_point now);
+
+    int removeOrder(OrderId orderId, PoolIndex orderIndex); // Remove a resting order from the book & the pool, returns the updateLimitLevelData key
+
+    int unlinkOrder(PoolIndex orderIndex);    // Remove an order from its limit level (it stays in the pool & the orders map), returns the updateLimitLevelData key
+    int linkOrder(PoolIndex orderIndex);      // Append an order to its limit level, returns the updateLimitLevelData key
+
+    template<typename Listener>
+    void sweepMarketOrder(Order order, Price protectionPrice, MarketLeftover leftover, uint64_t start, ExecutionListener<Listener>& listener);
+
+    // Latency recording, start is a Timestamp::start() value (no-ops when ORDERBOOK_NO_INSTRUMENTATION is defined)
+    void recordAddLatency(Type type, int key, uint64_t start);
+    void recordAmendLatency(AmendPath path, int key, uint64_t start);
+    void recordCancelLatency(int key, uint64_t start);
+    void recordMatchLatency(uint64_t start);
+
+    static std::string formatLatencyStats(const LatencyStats& stats, int& totalTransactions);  // Also gives the number of latencies recorded
     
 public:
-    OrderBook();    
+    // expectedOrders: pre-sizing hint for the order storage, to avoid growing it while trading
+    // verbosity: what is written to the console by the event log (LogVerbosity::Silent to only measure matching)
+    // pruneExpiredOrders: start a background thread cancelling the expired GFD & GTT orders. Turn it off when the owner
+    //                     calls expireOrders() itself (e.g. the Exchange workers, instead of one thread per book)
+    // clock: time used to expire the orders, the system clock unless a test or a replay controls it
+    OrderBook(size_t expectedOrders = 0, LogVerbosity verbosity = LogVerbosity::Orders, bool pruneExpiredOrders = true,
+                WallClock& clock = WallClock::system());
     ~OrderBook();
 
     uint32_t getNumberOfOrders() {return orders.size();}
-    
-    // Helper to get a random order ID from the current orders
-    uint32_t getRandomOrderId();
 
-    OrderPointer getOrderPtr(uint32_t orderId) {return orders[orderId].order;}
+    const Order* findOrder(uint32_t orderId) const;
+
+    // Executions are reported to the listener as the fills happen, without any allocation (see ExecutionListener.h)
+    // The listener templates are defined in OrderBook.cpp, which is compiled with the code using them (see test.cpp)
+    template<typename Listener>
+    void addOrder(Order order, ExecutionListener<Listener>& listener);
+    template<typename Listener>
+    void amendOrder(uint32_t orderId, Price newPrice, uint32_t newShares, ExecutionListener<Listener>& listener);
+    template<typename T, typename Listener, IfDecimalPrice<T> = 0>
+    void amendOrder(uint32_t orderId, T newPrice, uint32_t newShares, ExecutionListener<Listener>& listener) = delete;    // Prices are in ticks (see toTicks)
+
+    /*  Market order sweeping the opposite side from its best level, up to protectionPrice (0: no protection), what's left is
+        either rested as a GTC order (at protectionPrice, or the last traded price without protection) or cancelled.
+        addOrder sweeps market orders without protection and rests their leftover. Throws std::invalid_argument if it isn't a market order   */
+    template<typename Listener>
+    void addMarketOrder(Order order, Price protectionPrice, MarketLeftover leftover, ExecutionListener<Listener>& listener);
+    template<typename T, typename Listener, IfDecimalPrice<T> = 0>
+    void addMarketOrder(Order order, T protectionPrice, MarketLeftover leftover, ExecutionListener<Listener>& listener) = delete;
 
-    Trades addOrder(OrderPointer orderPtr, bool newOrder = true, double initLatencyCount = 0);
+    // Trades API: adapters collecting the executions into a Trades vector
+    Trades addOrder(Order order);
     void cancelOrder(uint32_t orderId, bool lockOn = true, bool amendedOrder = false);
-    Trades amendOrder(OrderPointer orderPtr, double newPrice, uint32_t newShares);
+    Trades amendOrder(uint32_t orderId, Price newPrice, uint32_t newShares);
+    template<typename T, IfDecimalPrice<T> = 0>
+    Trades amendOrder(uint32_t orderId, T newPrice, uint32_t newShares) = delete;
+
+    // Batch API (replays, opening loads): a single lock for the whole batch, orders are only matched when they cross the book,
+    // and the executions go to the listener, or are appended to the caller's trades buffer (which can be reused from one batch to the next)
+    template<typename Listener>
+    void addOrders(const Order* newOrders, size_t nOrders, ExecutionListener<Listener>& listener);
+    template<typename Listener>
+    void addOrders(const std::vector<Order>& newOrders, ExecutionListener<Listener>& listener) {addOrders(newOrders.data(), newOrders.size(), listener);}
+    template<typename Listener>
+    void applyCommands(const OrderCommand* commands, size_t nCommands, ExecutionListener<Listener>& listener);
+    template<typename Listener>
+    void applyCommands(const std::vector<OrderCommand>& commands, ExecutionListener<Listener>& listener) {applyCommands(commands.data(), commands.size(), listener);}
+
+    void addOrders(const Order* newOrders, size_t nOrders, Trades& trades);
+    void addOrders(const std::vector<Order>& newOrders, Trades& trades) {addOrders(newOrders.data(), newOrders.size(), trades);}
+    void applyCommands(const OrderCommand* commands, size_t nCommands, Trades& trades);
+    void applyCommands(const std::vector<OrderCommand>& commands, Trades& trades) {applyCommands(commands.data(), commands.size(), trades);}
+
+    static constexpr uint32_t TRADING_CLOSE_HOUR = 16;  // GFD orders expire at TRADING_CLOSE_HOUR:00 local time
+    static constexpr size_t EXPIRY_CHUNK = 256;         // Default number of orders expired under one lock acquisition
+
+    /*  Cancel up to maxOrders GFD & GTT orders whose expiry time has passed, returns the number of due orders left.
+        The owner calls it again between other requests until it returns 0, thus a large expiry never freezes the book.
+        GTT orders expire at their expiry time (given in seconds, see Order::setExpiry), GFD orders at the market close.   */
+    size_t expireOrders(size_t maxOrders = EXPIRY_CHUNK);
+
+    bool expireOrder(uint32_t orderId);    // Expire a resting order now, whatever its expiry (journal replays), false if it isn't in the book
+
+    static std::chrono::system_clock::time_point nextMarketClose(std::chrono::system_clock::time_point now, uint32_t closeHour = TRADING_CLOSE_HOUR);
+
+    // Top of book & depth, served from the limit level data (no per-order work). An empty side gives a level of price 0 with no shares
+    LimitLevelInfo getBestBid();
+    LimitLevelInfo getBestAsk();
+    LimitLevel getTopOfBook();  // Best bid & ask read under the same lock
+    size_t getDepth(Side side, size_t nLevels, LimitLevelInfos& levels);   // Best nLevels levels (or less) into levels, reusing its memory
+    template<typename T, IfDecimalPrice<T> = 0>
+    size_t getDepth(Side side, T nLevels, LimitLevelInfos& levels) = delete;
+    Price getSpread();      // In ticks, 0 if a side is empty
+
+    // Whether FOK checks against this side use the cumulative depth index, false while outlier prices make them walk the levels
+    bool hasDepthIndex(Side side) const {return (side == Side::Bid) ? bidDepth.isEnabled() : askDepth.isEnabled();}
+    double getMidPrice();   // Decimal price, 0.0 if a side is empty
+
+    // L2 market data: the handler receives every level update following the snapshot (see MarketData.h)
+    MarketDataSubscription subscribeMarketData(LevelUpdateHandler handler);
+    void unsubscribeMarketData(SubscriptionId id);
+    BookSnapshot getSnapshot();
+
+    /*  Full state of the book (levels, orders in time priority, expiries) in a binary file with a checksum (see BookFile.h).
+        loadSnapshot rebuilds an empty book from it without matching, throws std::runtime_error if the file is invalid (including
+        levels out of order or crossing, and market, FAK or FOK orders, which never rest) and std::logic_error if the book isn't
+        empty. It returns the number of GFD & GTT orders loaded past their expiry, which the next expireOrders call cancels.
+        Defined in BookFile.cpp.   */
+    void saveSnapshot(const std::string& filename);
+    size_t loadSnapshot(const std::string& filename);
+
+    /*  Journal every command accepted from now on (nullptr: stop journaling), the journal must outlive the book or be detached.
+        The records are appended under the lock, in the order the commands are applied, and made durable by the journal's
+        flusher: a caller acknowledging a command only once it's durable waits for journal->getLastSequence() (see Journal.h).
+        Internal cancels (the rest of a FAK order) aren't journaled, the replay of the command that triggered them repeats them.   */
+    void attachJournal(JournalWriter* journal);
+
+    /*  Publish the top of the book, the last trade & the L2 sequence number to view after each command that changes them
+        (nullptr: stop publishing), the view must outlive the book or be detached. Readers poll it without the lock.   */
+    void attachView(BookView* view);
 
     void printOrderBook() const;
 
     void clearLatencies();
 
+    // Latency statistics & memory usage (the content of writeLatencyStatsToFile) as JSON text, safe to call while the book is used
+    std::string getLatencyStats();
+
+    /*  The same in two steps, thus the thread owning the book copies the statistics between two commands and another thread
+        formats them (see Sequencer): copyLatencyStats copies them under the lock into the existing histograms of stats (no
+        allocation once every key has been copied, only ~30 kB copied per histogram), formatLatencyStats turns a copy into JSON text   */
+    void copyLatencyStats(LatencyStats& stats);
+    static std::string formatLatencyStats(const LatencyStats& stats);
+
     void writeLatencyStatsToFile(const std::string& filename, int nUpdates = -1);
 };
\ No newline at end of file
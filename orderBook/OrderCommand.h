@@ -0,0 +1,45 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+
+#include <cstdint>
+
+enum class CommandType : uint8_t {Add = 0, Cancel, Amend};
+
+/*  Fixed-size, trivially copyable request to an order book (add, cancel or amend an order).
+    Unlike Order it can be default constructed and copied into pre-allocated ring buffers.   */
+struct OrderCommand{
+    CommandType command = CommandType::Add;
+    Type type = Type::GTC;
+    Side side = Side::Bid;
+    SymbolId symbol = 0;
+    OrderId orderId = 0;
+    Price price = 0;        // New price for amendments, unused for cancellations & market orders
+    Quantity shares = 0;    // New number of shares for amendments, unused for cancellations
+    ExpiryTime expiry = 0;  // Expiry of GTT orders
+
+    static OrderCommand add(const Order& order){
+        return OrderCommand{CommandType::Add, order.getOrderType(), order.getOrderSide(), order.getOrderSymbol(),
+                            order.getOrderId(), order.getOrderPrice(), order.getOrderShares(), order.getOrderExpiry()};
+    }
+
+    static OrderCommand cancel(SymbolId symbol, OrderId orderId){
+        return OrderCommand{CommandType::Cancel, Type::GTC, Side::Bid, symbol, orderId, 0, 0};
+    }
+
+    static OrderCommand amend(SymbolId symbol, OrderId orderId, Price newPrice, Quantity newShares){
+        return OrderCommand{CommandType::Amend, Type::GTC, Side::Bid, symbol, orderId, newPrice, newShares};
+    }
+
+    Order toOrder() const{
+        /* Order to add (may throw std::invalid_argument, see the Order constructors) */
+        if (type == Type::M)
+            return Order(orderId, type, side, shares, symbol);
+
+        Order order(orderId, type, side, price, shares, symbol);
+        if (type == Type::GTT)
+            order.setExpiry(expiry);
+        return order;
+    }
+};  // 24 bytes
@@ -0,0 +1,204 @@
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "OrderFile.h"
+#include "OrderBook.h"
+
+
+void validateOrderFileHeader(const OrderFileHeader& header, const std::string& filename){
+    if (std::memcmp(header.magic, ORDER_FILE_MAGIC, sizeof(ORDER_FILE_MAGIC)) != 0)
+        throw std::runtime_error((std::ostringstream{} << filename << " is not an order file").str());
+
+    if (header.version != ORDER_FILE_VERSION || header.recordSize != sizeof(OrderRecord))
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " has an unsupported version (" << header.version << ") or record size (" << header.recordSize << ")").str()
+        );
+}
+
+
+MappedFile::MappedFile(const std::string& filename){
+#ifdef _WIN32
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE){
+        fileHandle = nullptr;
+        throw std::runtime_error((std::ostringstream{} << "Cannot open file " << filename).str());
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)){
+        close();
+        throw std::runtime_error((std::ostringstream{} << "Cannot get the size of file " << filename).str());
+    }
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+
+    if (mappedSize == 0)
+        return;     // Empty files can't be mapped
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle != nullptr)
+        mappedData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+#else
+    fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+        throw std::runtime_error((std::ostringstream{} << "Cannot open file " << filename).str());
+
+    struct stat fileStatus;
+    if (::fstat(fileDescriptor, &fileStatus) != 0){
+        close();
+        throw std::runtime_error((std::ostringstream{} << "Cannot get the size of file " << filename).str());
+    }
+    mappedSize = static_cast<size_t>(fileStatus.st_size);
+
+    if (mappedSize == 0)
+        return;     // Empty files can't be mapped
+
+    void* address = ::mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (address != MAP_FAILED){
+        mappedData = static_cast<const char*>(address);
+        ::madvise(address, mappedSize, MADV_SEQUENTIAL);    // Read ahead aggressively, the records are read in order
+    }
+#endif
+
+    if (mappedData == nullptr){
+        close();
+        throw std::runtime_error((std::ostringstream{} << "Cannot memory map file " << filename).str());
+    }
+}
+
+
+void MappedFile::close(){
+#ifdef _WIN32
+    if (mappedData != nullptr)
+        UnmapViewOfFile(mappedData);
+    if (mappingHandle != nullptr)
+        CloseHandle(mappingHandle);
+    if (fileHandle != nullptr)
+        CloseHandle(fileHandle);
+    mappingHandle = fileHandle = nullptr;
+#else
+    if (mappedData != nullptr)
+        ::munmap(const_cast<char*>(mappedData), mappedSize);
+    if (fileDescriptor >= 0)
+        ::close(fileDescriptor);
+    fileDescriptor = -1;
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+}
+
+
+bool sameFileContents(const std::string& filename, const std::string& otherFilename){
+    MappedFile file(filename), otherFile(otherFilename);
+    return file.size() == otherFile.size() && (file.size() == 0 || std::memcmp(file.data(), otherFile.data(), file.size()) == 0);
+}
+
+
+OrderFileReader::OrderFileReader(const std::string& filename): file(filename){
+    if (file.size() < sizeof(OrderFileHeader))
+        throw std::runtime_error((std::ostringstream{} << filename << " is too small to be an order file").str());
+
+    header = reinterpret_cast<const OrderFileHeader*>(file.data());
+    records = reinterpret_cast<const OrderRecord*>(file.data() + sizeof(OrderFileHeader));
+
+    validateOrderFileHeader(*header, filename);
+
+    if ((file.size() - sizeof(OrderFileHeader)) / sizeof(OrderRecord) < header->nRecords)
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " is truncated: " << header->nRecords << " records expected").str()
+        );
+}
+
+
+OrderFileWriter::OrderFileWriter(const std::string& filename, double _tickSize): file(filename, std::ios::binary | std::ios::trunc), tickSize(_tickSize){
+    if (!file.is_open())
+        throw std::runtime_error((std::ostringstream{} << "Cannot open file " << filename << " for writing").str());
+
+    writeHeader();  // Rewritten with the number of records when closing
+}
+
+
+void OrderFileWriter::writeHeader(){
+    OrderFileHeader header{};
+    std::memcpy(header.magic, ORDER_FILE_MAGIC, sizeof(ORDER_FILE_MAGIC));
+    header.version = ORDER_FILE_VERSION;
+    header.recordSize = sizeof(OrderRecord);
+    header.nRecords = nRecords;
+    header.tickSize = tickSize;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+
+void OrderFileWriter::write(const OrderRecord& record){
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    ++nRecords;
+}
+
+
+void OrderFileWriter::close(){
+    if (!file.is_open())
+        return;
+
+    file.seekp(0);
+    writeHeader();
+    file.close();
+}
+
+
+OrderFileLoadResult loadOrderFile(const std::string& filename, OrderBook& orderBook, size_t batchSize){
+    OrderFileReader reader(filename);
+
+    if (std::abs(reader.getTickSize() - DEFAULT_TICK_SIZE) > 1e-12)
+        throw std::runtime_error(
+            (std::ostringstream{} << filename << " has a tick size of " << reader.getTickSize() << " instead of " << DEFAULT_TICK_SIZE).str()
+        );
+
+    OrderFileLoadResult result;
+
+    std::vector<Order> batch;
+    batch.reserve(batchSize);
+    TradeCounter tradeCounter;
+
+    for (const OrderRecord& record : reader){
+        try{
+            batch.push_back(record.toOrder());
+        }
+        catch (const std::invalid_argument&){
+            ++result.nInvalid;
+            continue;
+        }
+        result.maxOrderId = std::max(result.maxOrderId, record.orderId);
+
+        if (batch.size() == batchSize){
+            orderBook.addOrders(batch, tradeCounter);
+            result.nLoaded += batch.size();
+            batch.clear();
+        }
+    }
+
+    orderBook.addOrders(batch, tradeCounter);
+    result.nLoaded += batch.size();
+    result.nTrades = tradeCounter.nTrades;
+
+    return result;
+}
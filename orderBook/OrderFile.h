@@ -0,0 +1,144 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+#include "Trade.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <fstream>
+
+/*  Compact binary order file: a 32-byte header followed by fixed-size 32-byte records, little endian.
+    Unlike orders.json, loading it needs no parsing nor string lookup: the file is memory mapped and the records
+    are read in place (see OrderFileReader), thus startup time is bounded by the disk/page cache bandwidth.
+    Files are written by OrderFileWriter (e.g. convert_orders.cpp converts orders.json).   */
+
+constexpr char ORDER_FILE_MAGIC[8] = {'O', 'B', 'O', 'R', 'D', 'E', 'R', 'S'};
+constexpr uint32_t ORDER_FILE_VERSION = 2;   // 2: records carry the expiry of GTT orders
+
+struct OrderFileHeader{
+    char magic[8];          // ORDER_FILE_MAGIC
+    uint32_t version;       // ORDER_FILE_VERSION
+    uint32_t recordSize;    // sizeof(OrderRecord)
+    uint64_t nRecords;
+    double tickSize;        // Prices are stored in ticks of tickSize
+};
+
+struct OrderRecord{
+    uint64_t timestamp;     // Nanoseconds since the start of the session (0 if unknown), used to pace replays
+    OrderId orderId;
+    Price price;            // In ticks, ignored for market orders
+    Quantity shares;
+    ExpiryTime expiry;      // GTT orders, ignored for the other types (GFD orders expire at the close of the day they rest)
+    SymbolId symbol;
+    Type type;
+    Side side;
+    uint8_t padding[4];
+
+    static OrderRecord fromOrder(const Order& order, uint64_t timestamp = 0){
+        const ExpiryTime expiry = (order.getOrderType() == Type::GTT) ? order.getOrderExpiry() : 0;
+        return OrderRecord{timestamp, order.getOrderId(), order.getOrderPrice(), order.getOrderShares(), expiry,
+                            order.getOrderSymbol(), order.getOrderType(), order.getOrderSide(), {}};
+    }
+
+    Order toOrder() const{
+        /* May throw std::invalid_argument, see the Order constructors & Order::setExpiry (a GTT order without expiry) */
+        if (type == Type::M)
+            return Order(orderId, type, side, shares, symbol);
+
+        Order order(orderId, type, side, price, shares, symbol);
+        if (type == Type::GTT)
+            order.setExpiry(expiry);
+        return order;
+    }
+};
+
+static_assert(sizeof(OrderFileHeader) == 32, "The order file header layout must not depend on the compiler");
+static_assert(sizeof(OrderRecord) == 32, "The order record layout must not depend on the compiler");
+
+void validateOrderFileHeader(const OrderFileHeader& header, const std::string& filename);   // Throws std::runtime_error if invalid
+
+
+// Read-only memory mapping of a whole file (mmap on POSIX, MapViewOfFile on Windows)
+class MappedFile{
+private:
+    const char* mappedData = nullptr;
+    size_t mappedSize = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    void close();
+
+public:
+    explicit MappedFile(const std::string& filename);   // Throws std::runtime_error if the file can't be mapped
+    ~MappedFile() {close();}
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const {return mappedData;}
+    size_t size() const {return mappedSize;}
+};
+
+
+// Whether both files hold the same bytes (e.g. the snapshots of two books, see BookFile.h), throws as MappedFile
+bool sameFileContents(const std::string& filename, const std::string& otherFilename);
+
+
+class OrderFileReader{
+private:
+    MappedFile file;
+    const OrderFileHeader* header;
+    const OrderRecord* records;
+
+public:
+    explicit OrderFileReader(const std::string& filename);  // Throws std::runtime_error if it isn't a valid order file
+
+    size_t size() const {return header->nRecords;}
+    double getTickSize() const {return header->tickSize;}
+
+    const OrderRecord& operator[](size_t index) const {return records[index];}
+    const OrderRecord* begin() const {return records;}
+    const OrderRecord* end() const {return records + header->nRecords;}
+};
+
+
+class OrderFileWriter{
+private:
+    std::ofstream file;
+    uint64_t nRecords = 0;
+    double tickSize;
+
+    void writeHeader();
+
+public:
+    explicit OrderFileWriter(const std::string& filename, double _tickSize = DEFAULT_TICK_SIZE);
+    ~OrderFileWriter() {close();}
+
+    void write(const OrderRecord& record);
+    void write(const Order& order, uint64_t timestamp = 0) {write(OrderRecord::fromOrder(order, timestamp));}
+
+    uint64_t getNumberOfRecords() const {return nRecords;}
+
+    void close();   // Writes the final number of records in the header
+};
+
+
+class OrderBook;
+
+struct OrderFileLoadResult{
+    size_t nLoaded = 0;     // Orders added to the book
+    size_t nInvalid = 0;    // Records that don't make a valid order (e.g. zero shares), skipped
+    size_t nTrades = 0;
+    OrderId maxOrderId = 0; // Highest order ID loaded, new orders can be numbered from maxOrderId + 1
+};
+
+/*  Add all the orders of the file to the book, in batches of batchSize orders (OrderBook::addOrders).
+    The batch buffer is allocated once and the trades are only counted, thus there is no allocation per record.   */
+OrderFileLoadResult loadOrderFile(const std::string& filename, OrderBook& orderBook, size_t batchSize = 4096);
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "enums.h"
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+/*  Flat open-addressing hash map from order IDs to Value (Robin Hood hashing).
+        - All entries live in one contiguous array: a lookup touches one or two cache lines, with no node allocation per order.
+        - Robin Hood insertion keeps probe sequences short by letting the entry farthest from its home slot take the place.
+        - Deletion shifts the following entries back by one slot (backward shift), thus there are no tombstones
+          and lookups don't get slower as orders come and go.
+    The capacity is always a power of 2 and the table grows once it is 7/8 full.   */
+template<typename Value>
+class OrderIdMap{
+private:
+    struct Slot{
+        OrderId key;
+        uint32_t distance;  // 1 + distance from the home slot of key, 0 if the slot is empty
+        Value value;
+    };
+
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<Slot> slots;
+    size_t nEntries = 0;
+    size_t mask = 0;
+    uint32_t shift = 64;
+
+    size_t homeSlot(OrderId key) const {
+        // Fibonacci hashing: consecutive IDs are spread over the whole table
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    size_t findSlot(OrderId key) const {
+        /* Return the slot holding key, or slots.size() if there is none */
+        if (slots.empty())
+            return slots.size();
+
+        size_t position = homeSlot(key);
+        for (uint32_t distance = 1; ; ++distance){
+            const Slot& slot = slots[position];
+
+            // Stop as soon as we reach an entry closer to its home than key would be (key would have taken its place)
+            if (slot.distance < distance)
+                return slots.size();
+            if (slot.key == key)
+                return position;
+
+            position = (position + 1) & mask;
+        }
+    }
+
+    void rehash(size_t capacity){
+        std::vector<Slot> oldSlots(capacity, Slot{0, 0, Value{}});
+        oldSlots.swap(slots);
+
+        mask = capacity - 1;
+        shift = 64;
+        for (size_t c = capacity; c > 1; c >>= 1)
+            --shift;
+
+        nEntries = 0;
+        for (auto& slot : oldSlots)
+            if (slot.distance != 0)
+                insert(slot.key, slot.value);
+    }
+
+public:
+    OrderIdMap(size_t expectedEntries = 0) {reserve(expectedEntries);}
+
+    size_t size() const {return nEntries;}
+    bool empty() const {return nEntries == 0;}
+    size_t capacity() const {return slots.size();}
+    size_t bytesReserved() const {return slots.capacity() * sizeof(Slot);}
+    static constexpr size_t slotSize() {return sizeof(Slot);}
+
+    void reserve(size_t nExpectedEntries){
+        /* Pre-size the table so that nExpectedEntries can be inserted without growing */
+        size_t capacity = MIN_CAPACITY;
+        while (capacity * 7 / 8 < nExpectedEntries)
+            capacity *= 2;
+
+        if (capacity > slots.size())
+            rehash(capacity);
+    }
+
+    bool contains(OrderId key) const {return findSlot(key) != slots.size();}
+
+    void prefetch(OrderId key) const{
+        /* Hint that key will be looked up or inserted soon: bulk loads hide the cache miss on its home slot */
+        if (!slots.empty()){
+#ifdef _MSC_VER
+            _mm_prefetch(reinterpret_cast<const char*>(&slots[homeSlot(key)]), _MM_HINT_T0);
+#else
+            __builtin_prefetch(&slots[homeSlot(key)]);
+#endif
+        }
+    }
+
+    Value* find(OrderId key){
+        size_t position = findSlot(key);
+        return (position == slots.size()) ? nullptr : &slots[position].value;
+    }
+
+    const Value* find(OrderId key) const{
+        size_t position = findSlot(key);
+        return (position == slots.size()) ? nullptr : &slots[position].value;
+    }
+
+    bool insert(OrderId key, const Value& value){
+        /* Insert (key, value) if key isn't already in the map. Returns whether it was inserted */
+        if ((nEntries + 1) * 8 > slots.size() * 7)
+            rehash(slots.empty() ? MIN_CAPACITY : 2 * slots.size());
+
+        Slot entry{key, 1, value};
+        size_t position = homeSlot(key);
+
+        while (true){
+            Slot& slot = slots[position];
+
+            if (slot.distance == 0){
+                slot = entry;
+                ++nEntries;
+                return true;
+            }
+
+            // No entry has been displaced before reaching an existing key (see findSlot), so entry is still (key, value)
+            if (slot.key == entry.key)
+                return false;
+
+            if (slot.distance < entry.distance)
+                std::swap(slot, entry);
+
+            position = (position + 1) & mask;
+            ++entry.distance;
+        }
+    }
+
+    bool erase(OrderId key){
+        /* Remove key from the map. Returns whether it was present */
+        size_t position = findSlot(key);
+        if (position == slots.size())
+            return false;
+
+        // Shift the following entries back until one is empty or already in its home slot
+        size_t next = (position + 1) & mask;
+        while (slots[next].distance > 1){
+            slots[position] = slots[next];
+            --slots[position].distance;
+            position = next;
+            next = (next + 1) & mask;
+        }
+
+        slots[position].distance = 0;
+        --nEntries;
+        return true;
+    }
+
+    template<typename Function>
+    void forEach(Function&& function) const{
+        /* Call function(key, value) on each entry, until it returns false */
+        for (const auto& slot : slots)
+            if (slot.distance != 0 && !function(slot.key, slot.value))
+                return;
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+/*  Slab allocator for orders: orders are constructed in fixed-size slabs which are never moved nor freed while the pool lives,
+    thus an order is identified by its PoolIndex and references to it remain valid until it is released.
+    Released slots are chained into a free list through the order's intrusive 'next' link and reused first.   */
+class OrderPool{
+private:
+    static constexpr uint32_t SLAB_BITS = 12;
+    static constexpr uint32_t SLAB_SIZE = 1 << SLAB_BITS;  // Number of orders per slab
+    static constexpr uint32_t SLAB_MASK = SLAB_SIZE - 1;
+
+    static_assert(std::is_trivially_destructible<Order>::value, "Orders are released without calling their destructor");
+
+    using Slot = std::aligned_storage_t<sizeof(Order), alignof(Order)>;
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    PoolIndex freeHead = NULL_INDEX;  // Head of the list of released slots
+    uint32_t nUsed = 0;     // Number of slots that were handed out at least once (high-water mark)
+    uint32_t nLive = 0;     // Number of orders currently allocated
+
+    Order* slot(PoolIndex index) const {return reinterpret_cast<Order*>(&slabs[index >> SLAB_BITS][index & SLAB_MASK]);}
+
+public:
+    OrderPool(size_t initialCapacity = 0) {reserve(initialCapacity);}
+
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    void reserve(size_t nOrders){
+        while (capacity() < nOrders)
+            slabs.emplace_back(new Slot[SLAB_SIZE]);
+    }
+
+    PoolIndex allocate(const Order& order){
+        /* Copy the given order into a free slot and return its index */
+        PoolIndex index;
+
+        if (freeHead != NULL_INDEX){
+            index = freeHead;
+            freeHead = slot(index)->next;
+        }
+        else{
+            index = nUsed++;
+            reserve(nUsed);
+        }
+
+        Order* orderPtr = new (slot(index)) Order(order);
+        orderPtr->prev = orderPtr->next = NULL_INDEX;
+        ++nLive;
+
+        return index;
+    }
+
+    void release(PoolIndex index){
+        slot(index)->next = freeHead;
+        freeHead = index;
+        --nLive;
+    }
+
+    void clear(){
+        /* Release every order at once, the slabs are kept */
+        freeHead = NULL_INDEX;
+        nUsed = nLive = 0;
+    }
+
+    Order& operator[](PoolIndex index) {return *slot(index);}
+    const Order& operator[](PoolIndex index) const {return *slot(index);}
+
+    size_t size() const {return nLive;}
+    size_t capacity() const {return slabs.size() * SLAB_SIZE;}
+    size_t bytesReserved() const {return capacity() * sizeof(Slot) + slabs.capacity() * sizeof(slabs[0]);}
+};
+
+
+/*  FIFO queue of the orders of a limit level, linked through the orders' intrusive prev/next links (no allocation per order).
+    Every operation takes the pool holding the orders.   */
+class OrderQueue{
+private:
+    PoolIndex head = NULL_INDEX;
+    PoolIndex tail = NULL_INDEX;
+
+public:
+    bool empty() const {return head == NULL_INDEX;}
+
+    PoolIndex front() const {return head;}
+    PoolIndex back() const {return tail;}
+
+    void pushBack(OrderPool& pool, PoolIndex index){
+        Order& order = pool[index];
+        order.prev = tail;
+        order.next = NULL_INDEX;
+
+        if (tail != NULL_INDEX)
+            pool[tail].next = index;
+        else
+            head = index;
+        tail = index;
+    }
+
+    void erase(OrderPool& pool, PoolIndex index){
+        Order& order = pool[index];
+
+        if (order.prev != NULL_INDEX)
+            pool[order.prev].next = order.next;
+        else
+            head = order.next;
+
+        if (order.next != NULL_INDEX)
+            pool[order.next].prev = order.prev;
+        else
+            tail = order.prev;
+
+        order.prev = order.next = NULL_INDEX;
+    }
+
+    PoolIndex popFront(OrderPool& pool){
+        PoolIndex index = head;
+        erase(pool, index);
+        return index;
+    }
+
+    template<typename Function>
+    void forEachOrder(const OrderPool& pool, Function&& function) const{
+        /* Call function(order) on each order from the oldest to the newest one, until it returns false */
+        for (PoolIndex index = head; index != NULL_INDEX; index = pool[index].next)
+            if (!function(pool[index]))
+                return;
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+/*  Prices are stored as a signed integer number of ticks (fixed-point), which makes them exact, cheap to hash & compare,
+    and safe to use as keys (46.09 and 46.0900001 map to the same limit level).
+    Conversions from/to decimal prices should only happen at the edges (JSON input, printing).  */
+using Price = int32_t;
+
+constexpr double DEFAULT_TICK_SIZE = 0.01;
+
+/*  A decimal price passed where ticks are expected would silently be truncated (48.57 -> 48 ticks, i.e. 0.48), thus the
+    functions taking a Price also declare a deleted overload for floating-point arguments: such a call doesn't compile.   */
+template<typename T>
+using IfDecimalPrice = std::enable_if_t<std::is_floating_point_v<T>, int>;
+
+inline Price toTicks(double price, double tickSize = DEFAULT_TICK_SIZE){
+    /* Throws std::out_of_range if the number of ticks doesn't fit in a Price */
+    const double ticks = std::round(price / tickSize);
+    if (!(ticks >= std::numeric_limits<Price>::min() && ticks <= std::numeric_limits<Price>::max()))
+        throw std::out_of_range((std::ostringstream{} << "Price " << price << " isn't representable in ticks of " << tickSize).str());
+    return static_cast<Price>(ticks);
+}
+
+inline double toDecimalPrice(Price ticks, double tickSize = DEFAULT_TICK_SIZE){
+    return ticks * tickSize;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "enums.h"
+#include "OrderPool.h"
+
+#include <map>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include <algorithm>
+
+/*  Two interchangeable backends holding the limit levels (price -> FIFO queue of orders) of one side of the book:
+        - MapLevels: a balanced binary tree (std::map), O(log n) to find or create a level.
+        - LadderLevels: a contiguous array of levels indexed by the tick offset from a reference price, O(1) to find or create a level.
+          The array covers at most LadderLevels::MAX_CAPACITY / 2 ticks around the levels, farther prices are kept in a std::map.
+    Both expose the same interface and iterate from the best to the worst price (descending for bids, ascending for asks).
+    The backend is selected at compile time by defining ORDERBOOK_LADDER (e.g. /DORDERBOOK_LADDER or -DORDERBOOK_LADDER).
+
+    Note: as with std::map, operator[] creates the level if needed and the caller is expected to insert an order into it,
+    while erase(price) must be called once the level becomes empty.   */
+
+
+template<Side S>
+class MapLevels{
+private:
+    // Bids are sorted by descending price and asks by ascending price, thus the best level is always the first one
+    using Compare = std::conditional_t<S == Side::Bid, std::greater<Price>, std::less<Price>>;
+
+    std::map<Price, OrderQueue, Compare> levels;
+
+public:
+    bool empty() const {return levels.empty();}
+    size_t size() const {return levels.size();}
+
+    OrderQueue& operator[](Price price) {return levels[price];}
+
+    void erase(Price price) {levels.erase(price);}
+
+    Price bestPrice() const {return levels.begin()->first;}
+    OrderQueue& best() {return levels.begin()->second;}
+
+    Price worstPrice() const {return levels.rbegin()->first;}
+
+    template<typename Function>
+    void forEachLevel(Function&& function) const{
+        /* Call function(price, orders) on each level from the best to the worst price, until it returns false */
+        for (const auto& item : levels)
+            if (!function(item.first, item.second))
+                return;
+    }
+};
+
+
+template<Side S>
+class LadderLevels{
+private:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 12;   // Number of ticks covered by the window before it has to grow
+    static constexpr size_t MAX_CAPACITY = 1 << 20;       // 8 MB of levels, prices further away go to the outliers
+
+    using Compare = std::conditional_t<S == Side::Bid, std::greater<Price>, std::less<Price>>;
+
+    std::vector<OrderQueue> levels;  // levels[i] holds the orders of price (basePrice + i)
+    Price basePrice = 0;
+
+    size_t nLevels = 0; // Number of non-empty levels in the window
+    size_t lowIndex = 0, highIndex = 0; // Indices of the lowest & highest non-empty levels (cached best/worst levels)
+
+    // Levels the window can't cover without growing beyond MAX_CAPACITY ticks (e.g. a far away order), best price first.
+    // They are never inside the window: moving the window takes in the ones it now covers
+    std::map<Price, OrderQueue, Compare> outliers;
+
+    size_t bestIndex() const {return (S == Side::Bid) ? highIndex : lowIndex;}
+    size_t worstIndex() const {return (S == Side::Bid) ? lowIndex : highIndex;}
+
+    static bool isBetter(Price price, Price otherPrice) {return Compare{}(price, otherPrice);}
+
+    bool inWindow(Price price) const {return price >= basePrice && price < basePrice + static_cast<Price>(levels.size());}
+
+    void insertLevel(size_t index){
+        /* Counts the new non-empty level at index */
+        if (nLevels == 0)
+            lowIndex = highIndex = index;
+        else{
+            lowIndex = std::min(lowIndex, index);
+            highIndex = std::max(highIndex, index);
+        }
+        ++nLevels;
+    }
+
+    bool moveWindow(Price price){
+        /*  Move (and grow if needed) the window so that it covers both the current non-empty levels and the given price.
+            Levels only hold the head/tail indices of their orders, thus moving them doesn't touch the orders.
+            Returns false (the window is left as is) if it would have to cover more than MAX_CAPACITY ticks.  */
+        int64_t low = price, high = price;
+        if (nLevels > 0){
+            low = std::min<int64_t>(low, basePrice + static_cast<Price>(lowIndex));
+            high = std::max<int64_t>(high, basePrice + static_cast<Price>(highIndex));
+        }
+
+        const size_t span = static_cast<size_t>(high - low) + 1;
+        if (span > MAX_CAPACITY / 2)
+            return false;
+
+        size_t capacity = std::max<size_t>(levels.size(), 2);
+        while (span > capacity / 2)  // Keep some room on both sides to avoid moving again soon
+            capacity *= 2;
+
+        const Price newBasePrice = static_cast<Price>(low - static_cast<int64_t>((capacity - span) / 2));
+        const Price shift = basePrice - newBasePrice;  // Index offset between the old and the new window (always >= 0 for non-empty levels)
+        std::vector<OrderQueue> newLevels(capacity);
+
+        if (nLevels > 0){
+            for (size_t i = lowIndex; i <= highIndex; ++i)
+                newLevels[i + shift] = levels[i];
+
+            lowIndex += shift;
+            highIndex += shift;
+        }
+
+        basePrice = newBasePrice;
+        levels.swap(newLevels);
+
+        // The outliers the window now covers move into it
+        for (auto it = outliers.begin(); it != outliers.end();){
+            if (!inWindow(it->first)){
+                ++it;
+                continue;
+            }
+            const size_t index = it->first - basePrice;
+            levels[index] = it->second;
+            insertLevel(index);
+            it = outliers.erase(it);
+        }
+        return true;
+    }
+
+public:
+    LadderLevels(size_t capacity = DEFAULT_CAPACITY): levels(capacity) {}
+
+    bool empty() const {return nLevels == 0 && outliers.empty();}
+    size_t size() const {return nLevels + outliers.size();}
+
+    OrderQueue& operator[](Price price){
+        if (!inWindow(price)){
+            auto outlier = outliers.find(price);
+            if (outlier != outliers.end())
+                return outlier->second;
+            if (!moveWindow(price))
+                return outliers[price];     // O(log outliers) for this level
+        }
+
+        size_t index = price - basePrice;
+        if (levels[index].empty())    // New limit level
+            insertLevel(index);
+
+        return levels[index];
+    }
+
+    void erase(Price price){
+        if (!inWindow(price)){
+            outliers.erase(price);
+            return;
+        }
+        if (nLevels == 0)
+            return;
+
+        size_t index = price - basePrice;
+        levels[index] = OrderQueue{};
+
+        if (--nLevels == 0)
+            return;
+
+        // Update the cached extreme levels by scanning towards the remaining ones
+        if (index == lowIndex)
+            while (levels[lowIndex].empty())
+                ++lowIndex;
+        if (index == highIndex)
+            while (levels[highIndex].empty())
+                --highIndex;
+    }
+
+    Price bestPrice() const{
+        const bool outlier = !outliers.empty() && (nLevels == 0 || isBetter(outliers.begin()->first, basePrice + static_cast<Price>(bestIndex())));
+        return outlier ? outliers.begin()->first : basePrice + static_cast<Price>(bestIndex());
+    }
+    OrderQueue& best(){
+        if (!outliers.empty() && (nLevels == 0 || isBetter(outliers.begin()->first, basePrice + static_cast<Price>(bestIndex()))))
+            return outliers.begin()->second;
+        return levels[bestIndex()];
+    }
+
+    Price worstPrice() const{
+        const bool outlier = !outliers.empty() && (nLevels == 0 || isBetter(basePrice + static_cast<Price>(worstIndex()), outliers.rbegin()->first));
+        return outlier ? outliers.rbegin()->first : basePrice + static_cast<Price>(worstIndex());
+    }
+
+    template<typename Function>
+    void forEachLevel(Function&& function) const{
+        /*  Call function(price, orders) on each level from the best to the worst price, until it returns false:
+            the outliers better than the window, the window, then the worse outliers   */
+        auto outlier = outliers.begin();
+        for (; outlier != outliers.end() && (nLevels == 0 || isBetter(outlier->first, basePrice)); ++outlier)
+            if (!function(outlier->first, outlier->second))
+                return;
+
+        if (nLevels > 0){
+            if (S == Side::Bid){
+                for (size_t i = highIndex + 1; i-- > lowIndex;)
+                    if (!levels[i].empty() && !function(basePrice + static_cast<Price>(i), levels[i]))
+                        return;
+            }
+            else{
+                for (size_t i = lowIndex; i <= highIndex; ++i)
+                    if (!levels[i].empty() && !function(basePrice + static_cast<Price>(i), levels[i]))
+                        return;
+            }
+        }
+
+        for (; outlier != outliers.end(); ++outlier)
+            if (!function(outlier->first, outlier->second))
+                return;
+    }
+};
+
+
+#ifdef ORDERBOOK_LADDER
+template<Side S> using PriceLevels = LadderLevels<S>;
+constexpr const char* PRICE_LEVELS_BACKEND = "ladder";
+#else
+template<Side S> using PriceLevels = MapLevels<S>;
+constexpr const char* PRICE_LEVELS_BACKEND = "map";
+#endif
@@ -0,0 +1,230 @@
+#include <thread>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "ReplaySource.h"
+#include "OrderBook.h"
+
+
+BinaryChunkReader::BinaryChunkReader(const std::string& filename): file(filename, std::ios::binary){
+    if (!file.is_open())
+        throw std::runtime_error((std::ostringstream{} << "Cannot open file " << filename).str());
+
+    OrderFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        throw std::runtime_error((std::ostringstream{} << filename << " is too small to be an order file").str());
+
+    validateOrderFileHeader(header, filename);
+    nRemaining = header.nRecords;
+}
+
+
+size_t BinaryChunkReader::read(OrderRecord* records, size_t maxRecords){
+    const size_t nRequested = static_cast<size_t>(std::min<uint64_t>(maxRecords, nRemaining));
+    file.read(reinterpret_cast<char*>(records), nRequested * sizeof(OrderRecord));
+
+    const size_t nRead = static_cast<size_t>(file.gcount()) / sizeof(OrderRecord);
+    nRemaining = (nRead < nRequested) ? 0 : nRemaining - nRead;    // A truncated file ends the stream
+    return nRead;
+}
+
+
+JsonLinesReader::JsonLinesReader(const std::string& filename): file(filename){
+    if (!file.is_open())
+        throw std::runtime_error((std::ostringstream{} << "Cannot open file " << filename).str());
+}
+
+
+size_t JsonLinesReader::read(OrderRecord* records, size_t maxRecords){
+    static const std::unordered_map<std::string, Type> types = {{"GTC", Type::GTC}, {"FAK", Type::FAK}, {"FOK", Type::FOK}, {"GFD", Type::GFD}, {"M", Type::M}, {"GTT", Type::GTT}};
+    static const std::unordered_map<std::string, Side> sides = {{"Bid", Side::Bid}, {"Ask", Side::Ask}};
+
+    size_t nRead = 0;
+
+    while (nRead < maxRecords && std::getline(file, line)){
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;   // Blank line
+
+        try{
+            const auto orderEntry = nlohmann::json::parse(line);
+
+            OrderRecord& record = records[nRead];
+            record.type = types.at(orderEntry.at("type").get<std::string>());
+            record.side = sides.at(orderEntry.at("side").get<std::string>());
+            record.price = toTicks(orderEntry.at("price").get<double>());
+            record.shares = orderEntry.at("shares").get<Quantity>();
+            record.expiry = orderEntry.contains("expiry") ? orderEntry["expiry"].get<ExpiryTime>() : 0;
+            record.orderId = orderEntry.contains("id") ? orderEntry["id"].get<OrderId>() : nextOrderId;
+            record.timestamp = orderEntry.contains("timestamp") ? orderEntry["timestamp"].get<uint64_t>() : 0;
+            record.symbol = orderEntry.contains("symbol") ? orderEntry["symbol"].get<SymbolId>() : 0;
+
+            nextOrderId = std::max(nextOrderId, record.orderId + 1);
+            ++nRead;
+        }
+        catch (const std::exception&){  // Parse error, missing field or unknown type/side
+            ++nInvalid;
+        }
+    }
+
+    return nRead;
+}
+
+
+ReplaySource::ReplaySource(std::unique_ptr<OrderStreamReader> _reader, ReplayPacing _pacing, double _speed, size_t chunkSize, size_t nChunks)
+: reader(std::move(_reader)), pacing(_pacing), speed(_speed), chunks(nChunks, std::vector<OrderRecord>(chunkSize)),
+    chunkSizes(nChunks, 0), freeChunks(nChunks), fullChunks(nChunks)
+{
+    if (speed <= 0.0)
+        throw std::invalid_argument((std::ostringstream{} << "The replay speed (" << speed << ") should be strictly positive").str());
+
+    for (uint32_t chunk = 0; chunk < nChunks; ++chunk)
+        freeChunks.tryPush(chunk);
+
+    readAheadThread = std::thread([this] {
+                                            readAhead();
+                                        }
+                                );
+}
+
+ReplaySource::~ReplaySource(){
+    stopping.store(true, std::memory_order_release);
+
+    if (readAheadThread.joinable())
+        readAheadThread.join();
+}
+
+
+std::unique_ptr<OrderStreamReader> ReplaySource::openReader(const std::string& filename){
+    if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0)
+        return std::make_unique<BinaryChunkReader>(filename);
+    return std::make_unique<JsonLinesReader>(filename);
+}
+
+
+void ReplaySource::readAhead(){
+    /* Read-ahead thread: fill the free chunks as soon as the consumer gives them back */
+    uint32_t chunk;
+
+    while (!stopping.load(std::memory_order_acquire)){
+        if (!freeChunks.tryPop(chunk)){
+            std::this_thread::yield();  // All the chunks are full, the consumer is behind
+            continue;
+        }
+
+        chunkSizes[chunk] = reader->read(chunks[chunk].data(), chunks[chunk].size());
+        if (chunkSizes[chunk] == 0)
+            break;  // End of the stream
+
+        fullChunks.tryPush(chunk);  // Can't fail: there are as many slots as chunks
+    }
+
+    readerDone.store(true, std::memory_order_release);
+}
+
+
+std::chrono::steady_clock::time_point ReplaySource::dueTime(const OrderRecord& record) const{
+    const uint64_t offset = (record.timestamp > firstTimestamp) ? record.timestamp - firstTimestamp : 0;
+    return startTime + std::chrono::nanoseconds(static_cast<int64_t>(offset / speed));
+}
+
+
+bool ReplaySource::tryNext(OrderRecord& record){
+    if (currentChunk == UINT32_MAX || position == chunkSizes[currentChunk]){
+        if (currentChunk != UINT32_MAX){
+            freeChunks.tryPush(currentChunk);   // Give the chunk back to the read-ahead thread
+            currentChunk = UINT32_MAX;
+        }
+
+        if (!fullChunks.tryPop(currentChunk)){
+            currentChunk = UINT32_MAX;
+            return false;
+        }
+        position = 0;
+    }
+
+    const OrderRecord& nextRecord = chunks[currentChunk][position];
+
+    if (!started){  // The replay clock starts with the first record
+        started = true;
+        firstTimestamp = nextRecord.timestamp;
+        startTime = std::chrono::steady_clock::now();
+    }
+    else if (pacing == ReplayPacing::OriginalTimestamps && std::chrono::steady_clock::now() < dueTime(nextRecord))
+        return false;
+
+    record = nextRecord;
+    ++position;
+    return true;
+}
+
+
+bool ReplaySource::finished() const{
+    // The read-ahead thread is done and every chunk it filled has been consumed
+    return readerDone.load(std::memory_order_acquire) && fullChunks.empty()
+            && (currentChunk == UINT32_MAX || position == chunkSizes[currentChunk]);
+}
+
+
+bool ReplaySource::next(OrderRecord& record){
+    while (!tryNext(record)){
+        if (finished())
+            return false;
+
+        // Sleep while the next record is far from due, otherwise spin to release it on time
+        if (pacing == ReplayPacing::OriginalTimestamps && currentChunk != UINT32_MAX && position < chunkSizes[currentChunk]){
+            auto wait = dueTime(chunks[currentChunk][position]) - std::chrono::steady_clock::now();
+            if (wait > std::chrono::milliseconds(1))
+                std::this_thread::sleep_for(wait - std::chrono::microseconds(500));
+        }
+        else
+            std::this_thread::yield();  // Waiting for the read-ahead thread
+    }
+    return true;
+}
+
+
+ReplayResult ReplaySource::replay(OrderBook& orderBook, size_t batchSize){
+    ReplayResult result;
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<Order> batch;
+    batch.reserve(batchSize);
+    TradeCounter tradeCounter;
+
+    auto flush = [&](){
+        if (batch.empty())
+            return;
+        orderBook.addOrders(batch, tradeCounter);
+        result.nReplayed += batch.size();
+        batch.clear();
+    };
+
+    OrderRecord record;
+    while (true){
+        if (!tryNext(record)){
+            flush();    // Nothing else is available (or due) right now, don't hold the orders back
+            if (!next(record))
+                break;
+        }
+
+        try{
+            batch.push_back(record.toOrder());
+            result.maxOrderId = std::max(result.maxOrderId, record.orderId);
+        }
+        catch (const std::invalid_argument&){
+            ++result.nInvalid;
+        }
+
+        if (batch.size() == batchSize)
+            flush();
+    }
+
+    flush();
+    result.nTrades = tradeCounter.nTrades;
+    result.nInvalid += reader->getNumberOfInvalidRecords();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+#include "OrderFile.h"
+#include "SpscQueue.h"
+#include "Trade.h"
+
+#include <cstdint>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+/*  Streaming order replay for inputs larger than RAM: the input is read incrementally, chunk by chunk, by a read-ahead
+    thread, while the orders already read are being matched. Only nChunks chunks of records are ever in memory.   */
+
+
+// Incremental reader of an order stream, called by the read-ahead thread only
+class OrderStreamReader{
+public:
+    virtual ~OrderStreamReader() = default;
+
+    // Read up to maxRecords records, returns the number read (0 once the stream is over)
+    virtual size_t read(OrderRecord* records, size_t maxRecords) = 0;
+
+    size_t getNumberOfInvalidRecords() const {return nInvalid;}
+
+protected:
+    size_t nInvalid = 0;    // Input that couldn't be turned into a record (skipped)
+};
+
+
+// Binary order file (see OrderFile.h) read with plain sequential reads, thus the file doesn't need to be mapped
+class BinaryChunkReader : public OrderStreamReader{
+private:
+    std::ifstream file;
+    uint64_t nRemaining;
+
+public:
+    explicit BinaryChunkReader(const std::string& filename);    // Throws std::runtime_error if it isn't a valid order file
+
+    size_t read(OrderRecord* records, size_t maxRecords) override;
+};
+
+
+/*  JSON lines: one order per line, e.g. {"type": "GTC", "side": "Bid", "price": 32.5, "shares": 100}
+    with optional "id", "timestamp" (nanoseconds), "symbol" and "expiry" (GTT orders, seconds since the Unix epoch) fields.
+    Orders without an ID are numbered 1, 2, ... and GTT orders without an expiry are counted as invalid.   */
+class JsonLinesReader : public OrderStreamReader{
+private:
+    std::ifstream file;
+    std::string line;
+    OrderId nextOrderId = 1;
+
+public:
+    explicit JsonLinesReader(const std::string& filename);  // Throws std::runtime_error if the file can't be opened
+
+    size_t read(OrderRecord* records, size_t maxRecords) override;
+};
+
+
+class OrderBook;
+
+enum class ReplayPacing {AsFastAsPossible = 0, OriginalTimestamps};  // OriginalTimestamps: orders are released at their recorded times
+
+struct ReplayResult{
+    size_t nReplayed = 0;   // Orders added to the book
+    size_t nInvalid = 0;    // Records skipped (unreadable input or invalid order)
+    size_t nTrades = 0;
+    OrderId maxOrderId = 0;
+    double seconds = 0.0;
+};
+
+
+class ReplaySource{
+private:
+    std::unique_ptr<OrderStreamReader> reader;
+    ReplayPacing pacing;
+    double speed;
+
+    // Chunk buffers circulate between the read-ahead thread (fills free chunks) and the consumer (reads full chunks)
+    std::vector<std::vector<OrderRecord>> chunks;
+    std::vector<size_t> chunkSizes;
+    SpscQueue<uint32_t> freeChunks;
+    SpscQueue<uint32_t> fullChunks;
+    std::atomic<bool> readerDone{false};
+    std::atomic<bool> stopping{false};
+    std::thread readAheadThread;
+
+    // Consumer state
+    uint32_t currentChunk = UINT32_MAX;
+    size_t position = 0;
+    bool started = false;
+    uint64_t firstTimestamp = 0;
+    std::chrono::steady_clock::time_point startTime;
+
+    void readAhead();
+
+    std::chrono::steady_clock::time_point dueTime(const OrderRecord& record) const;
+
+public:
+    /*  pacing: as fast as possible, or following the records' timestamps (relative to the first record)
+        speed: replay speed factor when following the timestamps (2.0 -> twice as fast)
+        chunkSize: number of records per chunk, nChunks: number of chunks read ahead   */
+    ReplaySource(std::unique_ptr<OrderStreamReader> _reader, ReplayPacing _pacing = ReplayPacing::AsFastAsPossible,
+                    double _speed = 1.0, size_t chunkSize = 4096, size_t nChunks = 8);
+    ~ReplaySource();
+
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // .bin files are read by a BinaryChunkReader, anything else by a JsonLinesReader
+    static std::unique_ptr<OrderStreamReader> openReader(const std::string& filename);
+
+    bool tryNext(OrderRecord& record);  // Next record if it is already read (and due when paced), doesn't wait
+    bool next(OrderRecord& record);     // Waits for the next record (and its time when paced), false at the end of the stream
+    bool finished() const;
+
+    size_t getNumberOfInvalidRecords() const {return reader->getNumberOfInvalidRecords();}  // Once finished
+
+    // Replay the whole stream into the book: records available (and due) at the same time are added as one batch
+    ReplayResult replay(OrderBook& orderBook, size_t batchSize = 4096);
+};
@@ -0,0 +1,263 @@
+#include <thread>
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+
+#include "Sequencer.h"
+
+
+static SequencerOptions sharedMode(size_t maxClients, size_t queueCapacity, size_t resultQueueCapacity, size_t expectedOrders, LogVerbosity verbosity){
+    SequencerOptions options;
+    options.maxClients = maxClients;
+    options.queueCapacity = queueCapacity;
+    options.resultQueueCapacity = resultQueueCapacity;
+    options.expectedOrders = expectedOrders;
+    options.verbosity = verbosity;
+    return options;
+}
+
+
+Sequencer::Sequencer(size_t maxClients, size_t queueCapacity, size_t resultQueueCapacity, size_t expectedOrders, LogVerbosity verbosity)
+: Sequencer(sharedMode(maxClients, queueCapacity, resultQueueCapacity, expectedOrders, verbosity)) {}
+
+
+Sequencer::Sequencer(const SequencerOptions& _options)
+: options(_options), book(_options.expectedOrders, _options.verbosity, false), inbound(_options.queueCapacity)   // GFD & GTT orders are expired by the matching thread
+{
+    if (options.maxClients == 0 || options.maxClients > HOUSEKEEPER)
+        throw std::invalid_argument(
+            (std::ostringstream{} << "The maximum number of clients (" << options.maxClients << ") should be between 1 and " << HOUSEKEEPER).str()
+        );
+
+    clients.reserve(options.maxClients);
+    for (size_t client = 0; client < options.maxClients; ++client)
+        clients.push_back(std::make_unique<Client>(options.resultQueueCapacity));
+
+    if (options.lockMemory)
+        tuningErrors += lockProcessMemory();    // Before the threads start, thus their stacks are locked as well
+
+    matchingThread = std::thread([this] {
+                                            run();
+                                        }
+                                );
+    tuningErrors += placeThread(matchingThread, options.matching);
+
+    if (options.housekeeping){
+        housekeepingThread = std::thread([this] {
+                                                    housekeep();
+                                                }
+                                        );
+        tuningErrors += placeThread(housekeepingThread, options.housekeeper);
+    }
+}
+
+Sequencer::~Sequencer(){
+    if (housekeepingThread.joinable()){
+        {
+            std::lock_guard<std::mutex> housekeepingLock{housekeepingMutex};
+            housekeepingStopping = true;
+        }
+        housekeepingWakeup.notify_one();
+        housekeepingThread.join();
+    }
+
+    stopping.store(true, std::memory_order_release);
+
+    if (matchingThread.joinable())
+        matchingThread.join();
+}
+
+
+ClientId Sequencer::registerClient(){
+    ClientId client = nClients.fetch_add(1, std::memory_order_relaxed);
+    if (client >= clients.size())
+        throw std::runtime_error(
+            (std::ostringstream{} << "Can't register more than " << clients.size() << " clients").str()
+        );
+    return client;
+}
+
+
+bool Sequencer::trySubmit(ClientId client, uint64_t requestId, const OrderCommand& command){
+    if (client >= nClients.load(std::memory_order_relaxed) || client >= clients.size())
+        throw std::out_of_range((std::ostringstream{} << "Unknown client (" << client << ")").str());
+
+    if (!inbound.tryPush(SequencedCommand{client, requestId, command}))
+        return false;
+
+    nSubmitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+
+void Sequencer::submit(ClientId client, uint64_t requestId, const OrderCommand& command){
+    while (!trySubmit(client, requestId, command))
+        std::this_thread::yield();  // The matching thread is behind, let it catch up
+}
+
+
+void Sequencer::drain(){
+    while (nProcessed.load(std::memory_order_acquire) < nSubmitted.load(std::memory_order_relaxed))
+        std::this_thread::yield();
+}
+
+
+void Sequencer::run(){
+    /*  Matching thread: apply the commands in arrival order. When the queue is empty it backs off (see IdleBackoff), and
+        expires the GFD & GTT orders each time it would yield, unless the housekeeping thread requests the expiries   */
+    const IdleBackoff backoff = options.backoff;
+    const uint32_t idleCycle = backoff.spins + backoff.pauses;
+
+    constexpr uint32_t EXPIRY_STRIDE = 64;  // Commands between two chunks of an expiry under load
+
+    SequencedCommand request;
+    uint32_t idlePolls = 0;
+    bool expiring = false;  // Due orders left from an expiry request, expired one chunk at a time between commands
+    uint32_t commandsSinceChunk = 0;
+
+    auto expireChunk = [this]{
+        /* Returns whether due orders are left */
+        const bool left = book.expireOrders() > 0;
+        if (!left)
+            expiryRequested.store(false, std::memory_order_release);
+        return left;
+    };
+
+    while (true){
+        if (inbound.tryPop(request)){
+            if (request.client == HOUSEKEEPER && request.requestId == COPY_STATS){
+                book.copyLatencyStats(statsCopy);   // Formatted by the housekeeping thread
+                statsCopied.store(true, std::memory_order_release);
+            }
+            else if (request.client == HOUSEKEEPER){
+                expiring = expireChunk();   // The first chunk right away
+                commandsSinceChunk = 0;
+            }
+            else{
+                execute(request);
+                nProcessed.store(nProcessed.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+                // A queue that never drains still expires its due orders: one chunk every EXPIRY_STRIDE commands
+                if (expiring && ++commandsSinceChunk >= EXPIRY_STRIDE){
+                    expiring = expireChunk();
+                    commandsSinceChunk = 0;
+                }
+            }
+            idlePolls = 0;
+            continue;
+        }
+
+        if (expiring){
+            expiring = expireChunk();   // One chunk at a time, the queue is polled again in between
+            commandsSinceChunk = 0;
+            continue;
+        }
+
+        if (stopping.load(std::memory_order_acquire) && nProcessed.load(std::memory_order_relaxed) >= nSubmitted.load(std::memory_order_acquire))
+            return;
+
+        if (++idlePolls < backoff.spins)
+            continue;
+        if (idlePolls < idleCycle){
+            cpuRelax();
+            continue;
+        }
+        idlePolls = backoff.yield ? 0 : backoff.spins;  // Without yielding, it keeps pausing
+
+        if (!options.housekeeping)
+            book.expireOrders();    // One chunk at a time, the queue is polled again in between
+
+        if (backoff.yield)
+            std::this_thread::yield();
+    }
+}
+
+
+void Sequencer::housekeep(){
+    /*  Housekeeping thread: requests an expiry from the matching thread every housekeepingInterval (unless the last one is still
+        being processed), and the statistics every statsInterval, which it writes once the matching thread has copied them.
+        It never touches the book, thus it never holds up the matching thread.   */
+    using Clock = std::chrono::steady_clock;
+    auto nextExport = Clock::now() + options.statsInterval;
+
+    std::unique_lock<std::mutex> housekeepingLock{housekeepingMutex};
+    while (!housekeepingStopping){
+        if (!expiryRequested.exchange(true, std::memory_order_acq_rel) && !inbound.tryPush(SequencedCommand{HOUSEKEEPER, EXPIRE_ORDERS, OrderCommand{}}))
+            expiryRequested.store(false, std::memory_order_release);    // The queue is full, requested again next time
+
+        if (!options.statsFilename.empty() && statsFailure.empty() && !statsRequested && Clock::now() >= nextExport){
+            statsRequested = inbound.tryPush(SequencedCommand{HOUSEKEEPER, COPY_STATS, OrderCommand{}});
+            if (statsRequested)
+                nextExport += options.statsInterval;    // Otherwise the queue is full, requested again next time
+        }
+
+        if (statsRequested && statsCopied.load(std::memory_order_acquire)){
+            housekeepingLock.unlock();
+
+            std::string failure;
+            try{
+                const std::string stats = OrderBook::formatLatencyStats(statsCopy);
+                std::ofstream file(options.statsFilename);
+                if (!(file << stats << std::endl))
+                    throw std::runtime_error((std::ostringstream{} << "Failed to write the statistics to " << options.statsFilename).str());
+            }
+            catch (const std::exception& e){
+                failure = e.what();
+            }
+
+            statsCopied.store(false, std::memory_order_relaxed);    // No request is in flight, the matching thread doesn't read it
+            housekeepingLock.lock();
+            statsRequested = false;
+            statsFailure = failure;
+        }
+
+        housekeepingWakeup.wait_for(housekeepingLock, options.housekeepingInterval, [this] {return housekeepingStopping;});
+    }
+}
+
+
+std::string Sequencer::getStatsFailure(){
+    std::lock_guard<std::mutex> housekeepingLock{housekeepingMutex};
+    return statsFailure;
+}
+
+
+void Sequencer::execute(const SequencedCommand& request){
+    Client& client = *clients[request.client];
+    const OrderCommand& command = request.command;
+
+    bool accepted = false;
+    TradeReporter tradeReporter(*this, client, request.requestId, command.orderId);
+
+    try{
+        switch (command.command){
+            case CommandType::Add:
+                if (book.findOrder(command.orderId) == nullptr){    // Not a duplicate
+                    book.addOrder(command.toOrder(), tradeReporter);
+                    accepted = tradeReporter.nTrades != 0 || book.findOrder(command.orderId) != nullptr;   // Either traded or rests in the book
+                }
+                break;
+            case CommandType::Cancel:
+                accepted = book.findOrder(command.orderId) != nullptr;
+                if (accepted)
+                    book.cancelOrder(command.orderId);
+                break;
+            case CommandType::Amend:
+                accepted = book.findOrder(command.orderId) != nullptr;
+                if (accepted)
+                    book.amendOrder(command.orderId, command.price, command.shares, tradeReporter);
+                break;
+        }
+    }
+    catch (const std::exception&){
+        accepted = false;
+    }
+
+    report(client, ExecutionReport{accepted ? ReportType::Accepted : ReportType::Rejected, request.requestId, command.orderId, 0, 0, 0});
+}
+
+
+void Sequencer::report(Client& client, const ExecutionReport& executionReport){
+    while (!client.results.tryPush(executionReport))
+        std::this_thread::yield();  // The client isn't polling fast enough
+}
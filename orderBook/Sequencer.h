@@ -0,0 +1,170 @@
+#pragma once
+
+#include "enums.h"
+#include "OrderCommand.h"
+#include "OrderBook.h"
+#include "MpscQueue.h"
+#include "SpscQueue.h"
+#include "ThreadPlacement.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+using ClientId = uint16_t;
+
+enum class ReportType : uint8_t {Trade = 0, Accepted, Rejected};
+
+struct ExecutionReport{
+    ReportType type;
+    uint64_t requestId;     // Given by the client when submitting the command
+    OrderId orderId;        // Order of the command
+    OrderId otherOrderId;   // Resting order it traded with (trades only)
+    Price price;            // Trade price, i.e. the resting order's price (trades only)
+    Quantity shares;        // Traded shares (trades only)
+};
+
+/*  Run mode of the sequencer. The defaults are the shared mode: the matching thread runs wherever the OS schedules it, yields
+    its core when idle and expires the GFD & GTT orders itself between polls. For predictable tail latency:
+        - matching: pin the matching thread to a core, optionally with SCHED_FIFO, and let it busy-poll (IdleBackoff::busyPoll())
+        - housekeeping: move the periodic work off the matching thread, to a thread pinned to another core. Every
+          housekeepingInterval it asks the matching thread to expire the due orders (only the matching thread touches the
+          book, thus an expiry never contends for its lock: the matching thread expires one chunk when asked, then one every
+          64 commands, or as soon as its queue is empty, until no due order is left), and every statsInterval it writes the book's
+          latency statistics to statsFilename (the matching thread copies them between two commands, the housekeeping thread
+          formats & writes them)
+        - lockMemory: mlockall, thus the hot path never page faults
+    Tuning the threads is best effort (see ThreadPlacement.h): what couldn't be applied is given by getTuningErrors().   */
+struct SequencerOptions{
+    size_t maxClients = 16;                 // Maximum number of order-entry clients
+    size_t queueCapacity = 1 << 16;         // Size of the inbound command queue, shared by all clients
+    size_t resultQueueCapacity = 1 << 16;   // Size of each client's result queue
+    size_t expectedOrders = 0;              // Pre-sizing hint for the order book
+    LogVerbosity verbosity = LogVerbosity::Silent;
+
+    ThreadPlacement matching;
+    IdleBackoff backoff;                    // Of the matching thread when the inbound queue is empty
+    bool lockMemory = false;
+
+    bool housekeeping = false;
+    ThreadPlacement housekeeper;
+    std::chrono::milliseconds housekeepingInterval{100};
+    std::string statsFilename;              // Empty: no statistics export
+    std::chrono::milliseconds statsInterval{1000};
+};
+
+
+/*  Single-writer (sequencer) mode of the order book: instead of locking the book from every order-entry thread,
+    clients push their commands into one lock-free MPSC queue, and a single matching thread applies them in arrival
+    order, thus the book's lock is never contended and expiring orders never blocks order entry.
+    The matching thread answers each command through the client's own SPSC result queue: one Trade report per trade
+    triggered by the command, then a final Accepted or Rejected report (the command had no effect, e.g. unknown order,
+    duplicate ID, FAK/FOK/market order that couldn't execute or invalid price).
+    Trades are only reported to the client whose command triggered them.
+    A client must keep polling its results: the matching thread waits while a client's result queue is full.   */
+class Sequencer{
+private:
+    static constexpr ClientId HOUSEKEEPER = UINT16_MAX;     // Client of the internal housekeeping requests, never registered
+    static constexpr uint64_t EXPIRE_ORDERS = 0;            // Request IDs of the housekeeping requests
+    static constexpr uint64_t COPY_STATS = 1;
+    struct SequencedCommand{
+        ClientId client = 0;
+        uint64_t requestId = 0;
+        OrderCommand command;
+    };
+
+    struct Client{
+        SpscQueue<ExecutionReport> results;
+        Client(size_t capacity): results(capacity) {}
+    };
+
+    // Sends a Trade report to the client for each execution of its command, as the fills happen
+    class TradeReporter : public ExecutionListener<TradeReporter>{
+    private:
+        Sequencer& sequencer;
+        Client& client;
+        uint64_t requestId;
+        OrderId orderId;
+
+    public:
+        size_t nTrades = 0;
+
+        TradeReporter(Sequencer& _sequencer, Client& _client, uint64_t _requestId, OrderId _orderId)
+        : sequencer(_sequencer), client(_client), requestId(_requestId), orderId(_orderId) {}
+
+        void onExecution(const Execution& execution){
+            sequencer.report(client, ExecutionReport{ReportType::Trade, requestId, orderId, execution.restingOrderId(), execution.price(), execution.shares});
+            ++nTrades;
+        }
+    };
+
+    SequencerOptions options;
+    OrderBook book;     // Only used by the matching thread
+    MpscQueue<SequencedCommand> inbound;
+    std::vector<std::unique_ptr<Client>> clients;   // Allocated upfront, as the matching thread reads it while clients register
+
+    std::atomic<ClientId> nClients{0};
+    alignas(64) std::atomic<uint64_t> nSubmitted{0};
+    alignas(64) std::atomic<uint64_t> nProcessed{0};
+
+    std::atomic<bool> stopping{false};
+    std::thread matchingThread;
+
+    std::atomic<bool> expiryRequested{false};   // An expiry request is queued or being processed by the matching thread
+    std::thread housekeepingThread;
+    std::mutex housekeepingMutex;
+    std::condition_variable housekeepingWakeup;
+    bool housekeepingStopping = false;
+    std::string statsFailure;       // Error of the last statistics export, which stops the exports
+
+    /*  Statistics handed off from the matching thread to the housekeeping thread: the housekeeping thread queues a COPY_STATS
+        request, the matching thread copies the book's statistics into statsCopy and sets statsCopied, then the housekeeping
+        thread formats & writes them and clears statsCopied. Only one request is in flight, thus they never use statsCopy at
+        the same time, and its histograms are reused from one export to the next.   */
+    LatencyStats statsCopy;
+    std::atomic<bool> statsCopied{false};
+    bool statsRequested = false;    // Housekeeping thread only: a COPY_STATS request is queued or its copy isn't written yet
+    std::string tuningErrors;
+
+    void run();
+    void housekeep();
+
+    void execute(const SequencedCommand& request);
+
+    void report(Client& client, const ExecutionReport& executionReport);
+
+public:
+    // Shared mode, see SequencerOptions for the arguments
+    Sequencer(size_t maxClients = 16, size_t queueCapacity = 1 << 16, size_t resultQueueCapacity = 1 << 16,
+                size_t expectedOrders = 0, LogVerbosity verbosity = LogVerbosity::Silent);
+    explicit Sequencer(const SequencerOptions& options);
+    ~Sequencer();   // Stops the housekeeping thread, processes the pending commands, then stops the matching thread
+
+    Sequencer(const Sequencer&) = delete;
+    Sequencer& operator=(const Sequencer&) = delete;
+
+    ClientId registerClient();  // Thread safe, throws once maxClients clients are registered
+
+    // Order-entry side, callable from any thread: trySubmit fails if the inbound queue is full, submit waits
+    bool trySubmit(ClientId client, uint64_t requestId, const OrderCommand& command);
+    void submit(ClientId client, uint64_t requestId, const OrderCommand& command);
+
+    // Only called by the client's own thread
+    bool tryPoll(ClientId client, ExecutionReport& executionReport) {return clients[client]->results.tryPop(executionReport);}
+
+    void drain();   // Wait until every submitted command has been processed
+
+    uint64_t getNumberOfProcessedCommands() const {return nProcessed.load(std::memory_order_acquire);}
+
+    const std::string& getTuningErrors() const {return tuningErrors;}  // Placements & memory locking that failed, "" if none
+    std::string getStatsFailure();
+
+    // Direct access to the book: only safe while the sequencer is drained and no command is being submitted
+    OrderBook& getOrderBook() {return book;}
+};
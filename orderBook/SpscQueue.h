@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*  Bounded lock-free single-producer/single-consumer ring buffer.
+    Exactly one thread may push and exactly one (other) thread may pop. Both operations are wait-free and never allocate:
+    tryPush fails when the queue is full and tryPop fails when it is empty.
+    The read & write positions live on separate cache lines, and each side caches the other side's position
+    to avoid touching the shared cache line on every call.   */
+template<typename T>
+class SpscQueue{
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    std::vector<T> buffer;
+    size_t mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head{0};   // Next position to read (written by the consumer)
+    size_t cachedTail = 0;  // Consumer's copy of tail
+
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail{0};   // Next position to write (written by the producer)
+    size_t cachedHead = 0;  // Producer's copy of head
+
+    static size_t roundUpToPowerOf2(size_t n){
+        size_t capacity = 2;
+        while (capacity < n)
+            capacity *= 2;
+        return capacity;
+    }
+
+public:
+    explicit SpscQueue(size_t capacity): buffer(roundUpToPowerOf2(capacity)), mask(buffer.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const {return buffer.size();}
+
+    bool tryPush(const T& item){
+        const size_t position = tail.load(std::memory_order_relaxed);
+
+        if (position - cachedHead == buffer.size()){
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == buffer.size())
+                return false;   // Full
+        }
+
+        buffer[position & mask] = item;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& item){
+        const size_t position = head.load(std::memory_order_relaxed);
+
+        if (position == cachedTail){
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail)
+                return false;   // Empty
+        }
+
+        item = buffer[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);}
+
+    size_t size() const{
+        const size_t readPosition = head.load(std::memory_order_acquire);  // Read first, so that it can't be ahead of tail
+        return tail.load(std::memory_order_acquire) - readPosition;
+    }
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+    #include <cerrno>
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #include <immintrin.h>
+#endif
+
+/*  Placement of latency-critical threads (see SequencerOptions): pinning a thread to a core keeps its caches & TLB warm
+    and stops the scheduler from migrating it, a real-time priority stops ordinary threads from preempting it, and
+    locking the process' memory avoids page faults on the hot path. All of it depends on the machine & the privileges
+    (SCHED_FIFO needs CAP_SYS_NICE or root, mlockall a large enough RLIMIT_MEMLOCK), thus these functions don't throw:
+    they return what couldn't be applied ("" if everything was), and the caller decides whether it can run without it.
+    For predictable latencies the cores given here should also be kept free of other work (isolcpus, nohz_full).   */
+
+struct ThreadPlacement{
+    int core = -1;              // Logical CPU the thread is pinned to, -1: wherever the OS schedules it
+    bool realtime = false;      // SCHED_FIFO on Linux (time-critical priority on Windows): only preempted by higher real-time threads
+    int priority = 50;          // SCHED_FIFO priority, from 1 to 99
+};
+
+
+inline std::string placeThread(std::thread& thread, const ThreadPlacement& placement){
+    /* Applies the placement to a running thread, returns what failed ("" on success) */
+    std::ostringstream errors;
+
+#ifdef _WIN32
+    const HANDLE handle = static_cast<HANDLE>(thread.native_handle());
+    if (placement.core >= 0){
+        if (placement.core >= 64 || SetThreadAffinityMask(handle, DWORD_PTR{1} << placement.core) == 0)
+            errors << "Can't pin the thread to core " << placement.core << " (error " << GetLastError() << "). ";
+    }
+    if (placement.realtime && !SetThreadPriority(handle, THREAD_PRIORITY_TIME_CRITICAL))
+        errors << "Can't raise the thread to time-critical priority (error " << GetLastError() << "). ";
+#elif defined(__linux__)
+    const pthread_t handle = thread.native_handle();
+    if (placement.core >= 0){
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        int error = EINVAL;
+        if (placement.core < CPU_SETSIZE){
+            CPU_SET(placement.core, &cpus);
+            error = pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+        }
+        if (error != 0)
+            errors << "Can't pin the thread to core " << placement.core << " (" << std::strerror(error) << "). ";
+    }
+    if (placement.realtime){
+        sched_param parameters{};
+        parameters.sched_priority = placement.priority;
+        const int error = pthread_setschedparam(handle, SCHED_FIFO, &parameters);
+        if (error != 0)
+            errors << "Can't set SCHED_FIFO priority " << placement.priority << " (" << std::strerror(error) << "). ";
+    }
+#else
+    (void) thread;
+    if (placement.core >= 0 || placement.realtime)
+        errors << "Thread placement isn't supported on this platform. ";
+#endif
+
+    return errors.str();
+}
+
+
+inline std::string lockProcessMemory(){
+    /* Keeps the current and future pages of the process in RAM (no page faults once touched), returns what failed ("" on success) */
+#if defined(_WIN32)
+    return "mlockall isn't supported on Windows (VirtualLock only locks given ranges). ";
+#else
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        return (std::ostringstream{} << "Can't lock the process' memory (" << std::strerror(errno) << "). ").str();
+    return "";
+#endif
+}
+
+
+inline void cpuRelax(){
+    /* Spin-wait hint: lets the sibling hyper-thread run and avoids the memory-order flush when the polled line changes */
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+
+/*  How a polling thread waits when its queue is empty: spins empty polls back to back, then pauses empty polls each after a
+    cpuRelax(), then it yields its core to the OS and starts over if yield is set, otherwise it keeps pausing.
+    Spinning reacts the fastest, yielding leaves the core to other threads (a pinned thread on an isolated core never has to).   */
+struct IdleBackoff{
+    uint32_t spins = 64;
+    uint32_t pauses = 0;
+    bool yield = true;
+
+    static IdleBackoff busyPoll() {return IdleBackoff{64, 1024, false};}   // Never gives the core away
+};
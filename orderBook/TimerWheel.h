@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <utility>
+#include <iterator>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*  Hierarchical timer wheel over 32-bit times (e.g. seconds since the epoch): LEVELS wheels of 64 slots, the slots of level L
+    spanning 64^L time units. A timer goes to the level of the highest 6-bit digit where its time differs from the current
+    time, thus scheduling is O(1), and it moves down one level at most per digit as the time reaches its slot (cascade).
+    Each level keeps a bitmap of its non-empty slots, thus advancing the time jumps straight to the next non-empty slot:
+    the cost of advance is O(expired + cascaded timers), however long the wheel stayed idle.
+    Timers can't be cancelled, the owner checks what each expired payload refers to (lazy deletion).   */
+template<typename Payload>
+class TimerWheel{
+private:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;     // 64 slots per level, one bit each in the level's bitmap
+    static constexpr uint32_t LEVELS = 6;                   // 36 bits >= 32-bit times, thus no overflow list is needed
+
+    struct Timer{
+        uint32_t time;
+        Payload payload;
+    };
+
+    std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> slots;
+    std::array<uint64_t, LEVELS> occupied{};    // Bit s of level L: slots[L][s] holds timers
+    std::vector<Payload> overdue;               // Timers scheduled at or before the current time
+    uint64_t currentTime;                       // Every timer up to this time has been expired
+    size_t nTimers = 0;
+
+    static uint32_t digit(uint64_t time, uint32_t level) {return static_cast<uint32_t>(time >> (level * SLOT_BITS)) & (SLOTS - 1);}
+
+    static uint32_t mostSignificantBit(uint64_t value){
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static uint32_t leastSignificantBit(uint64_t value){
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return index;
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    void place(uint32_t time, Payload payload){
+        if (time <= currentTime){
+            overdue.push_back(std::move(payload));
+            return;
+        }
+
+        const uint32_t level = mostSignificantBit(time ^ currentTime) / SLOT_BITS;
+        const uint32_t slot = digit(time, level);
+        slots[level][slot].push_back(Timer{time, std::move(payload)});
+        occupied[level] |= uint64_t(1) << slot;
+    }
+
+    uint64_t nextSlotTime(uint32_t& level) const{
+        /*  Start time of the next non-empty slot after the current time (UINT64_MAX if the wheel is empty), and its level.
+            The slot of the current digit of a level is always empty (its timers were cascaded when the time reached it),
+            and the slots of a lower level all start before the next slot of a higher one, thus the lowest level wins.   */
+        for (level = 0; level < LEVELS; ++level){
+            const uint32_t current = digit(currentTime, level);
+            const uint64_t later = (current == SLOTS - 1) ? 0 : occupied[level] & (~uint64_t(0) << (current + 1));
+            if (later == 0)
+                continue;
+
+            const uint32_t shift = level * SLOT_BITS;
+            return ((currentTime >> (shift + SLOT_BITS)) << (shift + SLOT_BITS)) | (uint64_t(leastSignificantBit(later)) << shift);
+        }
+        return UINT64_MAX;
+    }
+
+public:
+    explicit TimerWheel(uint32_t startTime = 0): currentTime(startTime) {}
+
+    size_t size() const {return nTimers;}   // Timers not expired yet (including the ones already cancelled by the owner)
+    bool empty() const {return nTimers == 0;}
+    uint32_t getCurrentTime() const {return static_cast<uint32_t>(currentTime);}
+
+    void schedule(uint32_t time, Payload payload){
+        /* A timer in the past expires at the next call to advance */
+        place(time, std::move(payload));
+        ++nTimers;
+    }
+
+    template<typename Payloads>
+    void advance(uint32_t time, Payloads& expired){
+        /* Move the time forward to time (never backward), appending the payload of every timer up to time to expired */
+        uint32_t level;
+        for (uint64_t slotTime = nextSlotTime(level); slotTime <= time; slotTime = nextSlotTime(level)){
+            currentTime = slotTime;
+
+            const uint32_t slot = digit(slotTime, level);
+            std::vector<Timer> timers;
+            timers.swap(slots[level][slot]);    // Now that the time is in this slot, its timers differ from it on lower digits only
+            occupied[level] &= ~(uint64_t(1) << slot);
+
+            for (Timer& timer : timers)
+                place(timer.time, std::move(timer.payload));  // Level 0 timers are exactly due: they all go to overdue
+
+            timers.clear();
+            slots[level][slot].swap(timers);    // Give the slot its memory back
+        }
+
+        if (time > currentTime)
+            currentTime = time;
+
+        nTimers -= overdue.size();
+        expired.insert(expired.end(), std::make_move_iterator(overdue.begin()), std::make_move_iterator(overdue.end()));
+        overdue.clear();
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+
+#if !defined(ORDERBOOK_CHRONO_TIMESTAMPS) && (defined(_M_X64) || defined(__x86_64__))
+    #define ORDERBOOK_TSC_TIMESTAMPS
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+        #include <cpuid.h>
+    #endif
+#endif
+
+/*  Timestamp source used to instrument the matching engine. Timestamps are raw ticks, only converted to nanoseconds
+    when a latency is recorded.
+        - TSC (default on x86-64): rdtsc at the start of a measurement and rdtscp at the end (waits for the measured
+          instructions to complete), ~10x cheaper than a clock syscall. The tick rate is calibrated once at startup
+          against steady_clock. If the CPU doesn't have an invariant TSC (its rate could change with the frequency),
+          we fall back to steady_clock at runtime.
+        - steady_clock: on other architectures, or when ORDERBOOK_CHRONO_TIMESTAMPS is defined.
+    Defining ORDERBOOK_NO_INSTRUMENTATION removes the instrumentation altogether (timestamps are always 0 and
+    latencies aren't recorded), to compare the instrumented and bare engines.   */
+
+#ifdef ORDERBOOK_NO_INSTRUMENTATION
+constexpr bool INSTRUMENTATION_ENABLED = false;
+#else
+constexpr bool INSTRUMENTATION_ENABLED = true;
+#endif
+
+class Timestamp{
+private:
+    struct Calibration{
+        bool useTsc = false;
+        double nanosecondsPerTick = 1.0;   // steady_clock ticks are converted to nanoseconds by steadyNow()
+    };
+
+    static uint64_t steadyNow(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+#ifdef ORDERBOOK_TSC_TIMESTAMPS
+    static bool hasInvariantTsc(){
+        /* CPUID leaf 0x80000007, EDX bit 8: the TSC runs at a constant rate in every P/C-state */
+#ifdef _MSC_VER
+        int registers[4];
+        __cpuid(registers, 0x80000000);
+        if (static_cast<unsigned int>(registers[0]) < 0x80000007)
+            return false;
+        __cpuid(registers, 0x80000007);
+        return (registers[3] & (1 << 8)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007 || !__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+            return false;
+        return (edx & (1u << 8)) != 0;
+#endif
+    }
+
+    static uint64_t tscStart() {return __rdtsc();}
+
+    static uint64_t tscStop(){
+        unsigned int aux;
+        return __rdtscp(&aux);
+    }
+#endif
+
+    static Calibration calibrate(){
+        /* Measure the TSC rate against steady_clock over a short busy wait */
+        Calibration result;
+        if constexpr (!INSTRUMENTATION_ENABLED)
+            return result;
+
+#ifdef ORDERBOOK_TSC_TIMESTAMPS
+        if (!hasInvariantTsc())
+            return result;
+
+        const uint64_t steadyStart = steadyNow();
+        const uint64_t tscBegin = tscStart();
+        uint64_t steadyEnd;
+        do {
+            steadyEnd = steadyNow();
+        } while (steadyEnd - steadyStart < 20'000'000);     // 20ms
+        const uint64_t tscEnd = tscStop();
+
+        if (tscEnd > tscBegin){
+            result.useTsc = true;
+            result.nanosecondsPerTick = static_cast<double>(steadyEnd - steadyStart) / (tscEnd - tscBegin);
+        }
+#endif
+        return result;
+    }
+
+    static inline const Calibration calibration = calibrate();   // Done once at startup
+
+public:
+    // Beginning of a measurement
+    static uint64_t start(){
+        if constexpr (!INSTRUMENTATION_ENABLED)
+            return 0;
+#ifdef ORDERBOOK_TSC_TIMESTAMPS
+        if (calibration.useTsc)
+            return tscStart();
+#endif
+        return steadyNow();
+    }
+
+    // End of a measurement: doesn't read the clock before the previous instructions complete
+    static uint64_t stop(){
+        if constexpr (!INSTRUMENTATION_ENABLED)
+            return 0;
+#ifdef ORDERBOOK_TSC_TIMESTAMPS
+        if (calibration.useTsc)
+            return tscStop();
+#endif
+        return steadyNow();
+    }
+
+    static uint64_t toNanoseconds(uint64_t ticks){
+        return calibration.useTsc ? static_cast<uint64_t>(ticks * calibration.nanosecondsPerTick) : ticks;
+    }
+
+    static uint64_t elapsedNanoseconds(uint64_t startTicks, uint64_t stopTicks){
+        return (stopTicks > startTicks) ? toNanoseconds(stopTicks - startTicks) : 0;
+    }
+
+    static const char* source(){
+        if constexpr (!INSTRUMENTATION_ENABLED)
+            return "disabled";
+        return calibration.useTsc ? "tsc" : "steady_clock";
+    }
+
+    static double ticksPerNanosecond() {return 1.0 / calibration.nanosecondsPerTick;}
+};
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "enums.h"
+
 #include <cstdint>
 #include <vector>
 
 struct TradeInfo{
     uint32_t orderId;
-    double price;
+    Price price;
     uint32_t shares;
 };
 
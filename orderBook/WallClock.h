@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <atomic>
+#include <chrono>
+
+/*  Source of the wall-clock time used to expire GFD & GTT orders. The order book reads it through this interface,
+    thus tests & replays can inject a ManualWallClock and move the time forward themselves instead of waiting.   */
+
+using ExpiryTime = uint32_t;    // Seconds since the Unix epoch (UTC), 0: the order doesn't expire
+
+inline ExpiryTime toExpiryTime(std::chrono::system_clock::time_point time){
+    return static_cast<ExpiryTime>(std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count());
+}
+
+inline std::chrono::system_clock::time_point fromExpiryTime(ExpiryTime time){
+    return std::chrono::system_clock::time_point(std::chrono::seconds(time));
+}
+
+
+class WallClock{
+public:
+    virtual ~WallClock() = default;
+
+    virtual std::chrono::system_clock::time_point now() const = 0;
+
+    static WallClock& system();     // The system clock, shared by every order book
+};
+
+
+class SystemWallClock : public WallClock{
+public:
+    std::chrono::system_clock::time_point now() const override {return std::chrono::system_clock::now();}
+};
+
+
+inline WallClock& WallClock::system(){
+    static SystemWallClock clock;
+    return clock;
+}
+
+
+// Time set by its owner (tests, replays), it can be read & moved from different threads
+class ManualWallClock : public WallClock{
+private:
+    std::atomic<int64_t> nanoseconds;   // Since the Unix epoch
+
+public:
+    explicit ManualWallClock(std::chrono::system_clock::time_point start = std::chrono::system_clock::now())
+    : nanoseconds(std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count()) {}
+
+    std::chrono::system_clock::time_point now() const override{
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds(nanoseconds.load(std::memory_order_acquire))));
+    }
+
+    void set(std::chrono::system_clock::time_point time){
+        nanoseconds.store(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(), std::memory_order_release);
+    }
+
+    void advance(std::chrono::nanoseconds duration) {nanoseconds.fetch_add(duration.count(), std::memory_order_acq_rel);}
+};
+
+
+inline std::tm toLocalTime(std::time_t time){
+    /* Portable localtime: localtime_s on Windows, localtime_r elsewhere (both are reentrant, unlike std::localtime) */
+    std::tm parts{};
+#ifdef _WIN32
+    localtime_s(&parts, &time);
+#else
+    localtime_r(&time, &parts);
+#endif
+    return parts;
+}
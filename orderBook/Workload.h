@@ -0,0 +1,285 @@
+#pragma once
+
+#include "enums.h"
+#include "Order.h"
+#include "OrderCommand.h"
+#include "OrderIdMap.h"
+#include "WallClock.h"
+#include "ExecutionListener.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+/*  Seeded order-flow generator, to drive an order book in process or to write a workload file (see generate_workload.cpp):
+        - the commands arrive as a Poisson process (exponential gaps between their timestamps)
+        - the mid price is a random walk of one tick steps, with a standard deviation of midVolatility ticks per √second
+        - limit prices cluster around the mid: the passive orders rest one tick or more away from it on their side (a geometric
+          distance), the aggressive ones cross it by a geometric distance
+        - the cancels & amends target an order drawn uniformly among the live ones, in O(1) (see LiveOrders), at a rate proportional
+          to the number of live orders: their ratios are the ones of a book of bookSize orders, around which the book settles
+    The generator knows the orders it added & cancelled. When it's also the listener of the book it drives, the filled orders are
+    removed as the executions happen, thus every cancel & amend targets a resting order. Otherwise (workload files) some of them
+    target orders that were filled meanwhile, which the book ignores.   */
+
+struct WorkloadOptions{
+    uint32_t seed = 42;
+    double arrivalRate = 100000.0;  // Mean number of commands per second
+    std::chrono::system_clock::time_point start = fromExpiryTime(1767605400);  // Time of the first command: 2026-01-05 09:30 UTC
+
+    // Share of each command (normalized) when bookSize orders are live, the cancels & amends scale with the number of live orders
+    double addRatio = 0.45;
+    double cancelRatio = 0.40;
+    double amendRatio = 0.15;
+    size_t bookSize = 10000;
+    double sizeDownRatio = 0.5;     // Amends that only lower the shares, at the same price (they keep their queue position)
+
+    // Share of each type among the adds (normalized), GTC for the rest
+    double marketRatio = 0.02;
+    double fakRatio = 0.03;
+    double fokRatio = 0.02;
+    double gfdRatio = 0.10;
+
+    Price initialMid = toTicks(30.0);
+    double midVolatility = 20.0;    // Ticks per √second
+    double meanDistance = 5.0;      // Mean distance of the passive prices to the mid, in ticks
+    double aggressiveRatio = 0.05;  // Limit orders priced through the mid
+    double meanShares = 50.0;
+    SymbolId symbol = 0;
+    OrderId firstOrderId = 1;
+};
+
+
+struct WorkloadCommand{
+    int64_t timestamp;      // Nanoseconds since the Unix epoch
+    OrderCommand command;
+
+    std::chrono::system_clock::time_point time() const{
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamp)));
+    }
+};
+
+
+/*  xoshiro256** (Blackman & Vigna), seeded with splitmix64: a few cycles per number where std::mt19937_64 and the standard
+    distributions cost tens of ns per draw, which would make the generator slower than the book it drives.   */
+class WorkloadRandom{
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));}
+
+public:
+    using result_type = uint64_t;
+    static constexpr result_type min() {return 0;}
+    static constexpr result_type max() {return std::numeric_limits<result_type>::max();}
+
+    explicit WorkloadRandom(uint64_t seed){
+        for (uint64_t& word : state){
+            uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()(){
+        const uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const uint64_t shifted = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= shifted;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    double unit() {return static_cast<double>((*this)() >> 11) * 0x1.0p-53;}     // [0, 1)
+
+    // Inverse transforms, a single logarithm each
+    double exponential(double mean) {return -mean * std::log(1.0 - unit());}
+    uint32_t geometric(double inverseLogFailure) {return static_cast<uint32_t>(std::log(1.0 - unit()) * inverseLogFailure);}    // 1 / log(1 - p)
+};
+
+
+/*  Set of live orders with O(1) insert, erase and uniform sampling: the orders are packed in a vector (an erased order is
+    replaced by the last one) and their position is indexed by id.   */
+class LiveOrders{
+public:
+    struct LiveOrder{
+        OrderId orderId;
+        Price price;
+        Quantity shares;
+        Side side;
+    };
+
+private:
+    std::vector<LiveOrder> liveOrders;
+    OrderIdMap<uint32_t> positions;     // Order id -> index in liveOrders
+
+public:
+    size_t size() const {return liveOrders.size();}
+    bool empty() const {return liveOrders.empty();}
+
+    void reserve(size_t nOrders){
+        liveOrders.reserve(nOrders);
+        positions.reserve(nOrders);
+    }
+
+    bool insert(const LiveOrder& order){
+        /* Returns false if the order is already live */
+        if (!positions.insert(order.orderId, static_cast<uint32_t>(liveOrders.size())))
+            return false;
+        liveOrders.push_back(order);
+        return true;
+    }
+
+    bool erase(OrderId orderId){
+        const uint32_t* position = positions.find(orderId);
+        if (position == nullptr)
+            return false;
+
+        const uint32_t index = *position;
+        if (index + 1 != liveOrders.size()){
+            liveOrders[index] = liveOrders.back();
+            *positions.find(liveOrders[index].orderId) = index;
+        }
+        liveOrders.pop_back();
+        positions.erase(orderId);
+        return true;
+    }
+
+    LiveOrder* find(OrderId orderId){
+        uint32_t* position = positions.find(orderId);
+        return (position == nullptr) ? nullptr : &liveOrders[*position];
+    }
+
+    template<typename Generator>
+    LiveOrder& sample(Generator& gen){
+        /* An order drawn uniformly, the set must not be empty */
+        return liveOrders[gen() % liveOrders.size()];
+    }
+};
+
+
+class WorkloadGenerator : public ExecutionListener<WorkloadGenerator>{
+private:
+    WorkloadOptions options;
+    WorkloadRandom gen;
+    double meanGap;             // Nanoseconds between two commands
+    double distanceFactor, sharesFactor;   // Of the geometric distributions (distance to the mid in ticks, shares)
+
+    // Command weights per live order, and cumulative thresholds of the types (drawn with a single uniform number)
+    double cancelWeight, amendWeight;
+    double marketThreshold, fakThreshold, fokThreshold, gfdThreshold;
+    double midStepProbability;  // Per command, for the mean gap: the variance of the walk is midVolatility² per second
+
+    LiveOrders liveOrders;
+    Price mid;
+    OrderId nextOrderId;
+    int64_t start;
+    double elapsed = 0.0;       // Nanoseconds since start
+
+    Price limitPrice(Side side){
+        /* Passive: on the order's side of the mid, aggressive: through it. Never below one tick */
+        const Price distance = 1 + static_cast<Price>(gen.geometric(distanceFactor));
+        const bool aggressive = gen.unit() < options.aggressiveRatio;
+        const Price price = ((side == Side::Bid) != aggressive) ? mid - distance : mid + distance;
+        return std::max<Price>(1, price);
+    }
+
+    Quantity shares() {return 1 + gen.geometric(sharesFactor);}
+
+    OrderCommand add(){
+        const Side side = (gen() & 1) ? Side::Bid : Side::Ask;
+        const OrderId orderId = nextOrderId++;
+        const double kind = gen.unit();
+
+        if (kind < marketThreshold)
+            return OrderCommand{CommandType::Add, Type::M, side, options.symbol, orderId, 0, shares(), 0};
+
+        const Type type = (kind < fakThreshold) ? Type::FAK : (kind < fokThreshold) ? Type::FOK : (kind < gfdThreshold) ? Type::GFD : Type::GTC;
+        const OrderCommand command{CommandType::Add, type, side, options.symbol, orderId, limitPrice(side), shares(), 0};
+
+        // Only the orders that can rest are targets of cancels & amends
+        if (type == Type::GTC || type == Type::GFD)
+            liveOrders.insert({orderId, command.price, command.shares, side});
+        return command;
+    }
+
+public:
+    explicit WorkloadGenerator(const WorkloadOptions& _options = {}):
+        options(_options), gen(_options.seed), meanGap(1e9 / _options.arrivalRate),
+        mid(_options.initialMid), nextOrderId(_options.firstOrderId),
+        start(std::chrono::duration_cast<std::chrono::nanoseconds>(_options.start.time_since_epoch()).count())
+    {
+        // 1 + a geometric number on 0, 1, ... of success probability 1 / mean: the given means
+        distanceFactor = 1.0 / std::log1p(-1.0 / std::max(1.0, options.meanDistance));
+        sharesFactor = 1.0 / std::log1p(-1.0 / std::max(2.0, options.meanShares));
+
+        const double bookSize = static_cast<double>(std::max<size_t>(1, options.bookSize));
+        cancelWeight = options.cancelRatio / bookSize;
+        amendWeight = options.amendRatio / bookSize;
+
+        const double totalTypes = std::max(1.0, options.marketRatio + options.fakRatio + options.fokRatio + options.gfdRatio);
+        marketThreshold = options.marketRatio / totalTypes;
+        fakThreshold = marketThreshold + options.fakRatio / totalTypes;
+        fokThreshold = fakThreshold + options.fokRatio / totalTypes;
+        gfdThreshold = fokThreshold + options.gfdRatio / totalTypes;
+
+        midStepProbability = std::min(1.0, options.midVolatility * options.midVolatility / options.arrivalRate);
+    }
+
+    WorkloadCommand next(){
+        elapsed += gen.exponential(meanGap);
+
+        // One tick up or down with probability midStepProbability
+        const double step = gen.unit();
+        if (step < midStepProbability)
+            mid = std::max<Price>(2, mid + ((step < midStepProbability / 2) ? 1 : -1));
+
+        const double nLive = static_cast<double>(liveOrders.size());
+        const double cancelRate = cancelWeight * nLive;
+        const double action = gen.unit() * (options.addRatio + cancelRate + amendWeight * nLive);
+        WorkloadCommand result{start + static_cast<int64_t>(elapsed), {}};
+
+        if (action < options.addRatio || liveOrders.empty())
+            result.command = add();
+        else if (action < options.addRatio + cancelRate){
+            const OrderId orderId = liveOrders.sample(gen).orderId;
+            liveOrders.erase(orderId);
+            result.command = OrderCommand::cancel(options.symbol, orderId);
+        }
+        else{
+            LiveOrders::LiveOrder& order = liveOrders.sample(gen);
+            if (order.shares > 1 && gen.unit() < options.sizeDownRatio)
+                order.shares = 1 + static_cast<Quantity>(gen() % (order.shares - 1));
+            else{
+                order.price = limitPrice(order.side);
+                order.shares = shares();
+            }
+            result.command = OrderCommand::amend(options.symbol, order.orderId, order.price, order.shares);
+        }
+
+        return result;
+    }
+
+    void onExecution(const Execution& execution){
+        /* Executions of the book driven by the generator: the filled orders are no longer targets */
+        for (OrderId orderId : {execution.bidOrderId, execution.askOrderId}){
+            LiveOrders::LiveOrder* order = liveOrders.find(orderId);
+            if (order != nullptr && (order->shares -= std::min(order->shares, execution.shares)) == 0)
+                liveOrders.erase(orderId);
+        }
+    }
+
+    void reserve(size_t nOrders) {liveOrders.reserve(nOrders);}
+
+    size_t getNumberOfLiveOrders() const {return liveOrders.size();}
+    Price getMid() const {return mid;}
+    OrderId getNextOrderId() const {return nextOrderId;}
+};
@@ -0,0 +1,93 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:book_query_benchmark.exe book_query_benchmark.cpp
+//  execute: ./book_query_benchmark.exe [number of resting orders...]     (default: 1000 100000 1000000)
+
+/*  Cost of the top-of-book & depth queries (getBestBid, getDepth, ...) as the book grows: they are served from the limit
+    level data, thus their cost shouldn't depend on the number of resting orders. The full snapshot (every level) is timed
+    for comparison. Each query is called nCalls times on a book of non-crossing GTC orders.   */
+
+using Clock = std::chrono::steady_clock;
+
+volatile uint64_t sink;   // Keeps the compiler from skipping the calls
+
+
+void populate(OrderBook& orderBook, size_t nOrders, uint32_t seed = 42){
+    /* Bids below 30.00 and asks above it, thus nothing trades and every order rests */
+    std::mt19937 gen(seed);
+    std::exponential_distribution<> distanceDist(1.0);
+    std::uniform_int_distribution<Quantity> sharesDist(1, 100);
+
+    std::vector<Order> orders;
+    orders.reserve(nOrders);
+    for (size_t i = 1; i <= nOrders; ++i){
+        const Side side = (i % 2) ? Side::Bid : Side::Ask;
+        const Price distance = 1 + static_cast<Price>(distanceDist(gen) * 100);   // Most orders near the touch
+        const Price price = toTicks(30.0) + ((side == Side::Bid) ? -distance : distance);
+        orders.emplace_back(static_cast<OrderId>(i), Type::GTC, side, price, sharesDist(gen));
+    }
+
+    NullListener noListener;
+    orderBook.addOrders(orders, noListener);
+}
+
+
+template<typename Query>
+double nanosecondsPerCall(size_t nCalls, Query&& query){
+    uint64_t checksum = 0;
+    auto start = Clock::now();
+    for (size_t i = 0; i < nCalls; ++i)
+        checksum += query();
+    double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    sink = checksum;
+    return elapsed / nCalls;
+}
+
+
+int main(int argc, char* argv[]){
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::stoull(argv[i]));
+    if (sizes.empty())
+        sizes = {1000, 100000, 1000000};
+
+    const size_t nCalls = 1000000;
+
+    std::cout << "Price levels backend: " << PRICE_LEVELS_BACKEND << ", nanoseconds per call" << std::endl;
+    std::cout << std::setw(10) << "Orders" << std::setw(10) << "Levels" << std::setw(10) << "BestBid" << std::setw(10) << "BestAsk"
+              << std::setw(10) << "TopOfBook" << std::setw(10) << "Spread" << std::setw(10) << "Mid"
+              << std::setw(10) << "Depth10" << std::setw(14) << "Snapshot" << std::endl;
+
+    for (size_t nOrders : sizes){
+        OrderBook orderBook(nOrders, LogVerbosity::Silent, false);
+        populate(orderBook, nOrders);
+
+        LimitLevelInfos levels;
+        levels.reserve(10);
+
+        const BookSnapshot snapshot = orderBook.getSnapshot();
+        const size_t nLevels = snapshot.bids.size() + snapshot.asks.size();
+        const size_t nSnapshotCalls = std::max<size_t>(10, nCalls / (nLevels + 1) / 10);
+
+        std::cout << std::setw(10) << nOrders << std::setw(10) << nLevels << std::fixed << std::setprecision(1)
+                  << std::setw(10) << nanosecondsPerCall(nCalls, [&]{return orderBook.getBestBid().totalShares;})
+                  << std::setw(10) << nanosecondsPerCall(nCalls, [&]{return orderBook.getBestAsk().totalShares;})
+                  << std::setw(10) << nanosecondsPerCall(nCalls, [&]{return orderBook.getTopOfBook().getBids().totalShares;})
+                  << std::setw(10) << nanosecondsPerCall(nCalls, [&]{return static_cast<uint64_t>(orderBook.getSpread());})
+                  << std::setw(10) << nanosecondsPerCall(nCalls, [&]{return static_cast<uint64_t>(orderBook.getMidPrice());})
+                  << std::setw(10) << nanosecondsPerCall(nCalls, [&]{return orderBook.getDepth(Side::Ask, 10, levels);})
+                  << std::setw(14) << nanosecondsPerCall(nSnapshotCalls, [&]{return orderBook.getSnapshot().bids.size();})
+                  << std::endl;
+    }
+}
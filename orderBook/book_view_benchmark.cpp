@@ -0,0 +1,147 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "BookView.h"
+#include "Workload.h"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:book_view_benchmark.exe book_view_benchmark.cpp
+//  execute: ./book_view_benchmark.exe [number of commands] [max number of readers]     (default: 2000000 commands, up to 8 readers)
+
+/*  Readers of the top of book & depth polling as fast as they can while the matching thread applies a seeded workload
+    (see Workload.h): through the book's lock (getTopOfBook & getDepth of BOOK_VIEW_LEVELS levels per side) vs through
+    the seqlock view (BookView.h). Reports the matching throughput and the reads per second as the number of readers grows.
+    Every snapshot read from the view is checked: levels sorted, book not crossed, sequence never going backward.   */
+
+using Clock = std::chrono::steady_clock;
+
+enum class ReadMode {Lock, View};
+
+
+bool isConsistent(const BookViewSnapshot& snapshot){
+    for (uint32_t i = 1; i < snapshot.nBids; ++i)
+        if (snapshot.bids[i].price >= snapshot.bids[i - 1].price)
+            return false;
+    for (uint32_t i = 1; i < snapshot.nAsks; ++i)
+        if (snapshot.asks[i].price <= snapshot.asks[i - 1].price)
+            return false;
+    return snapshot.nBids == 0 || snapshot.nAsks == 0 || snapshot.bids[0].price < snapshot.asks[0].price;
+}
+
+
+struct RunResult{
+    double commandsPerSecond;
+    double readsPerSecond;
+    uint64_t nInconsistent;
+};
+
+
+RunResult run(ReadMode mode, size_t nCommands, size_t nReaders){
+    WorkloadGenerator generator;
+    std::vector<WorkloadCommand> commands(nCommands);
+    for (auto& command : commands)
+        command = generator.next();
+
+    OrderBook book(nCommands, LogVerbosity::Silent, false);
+    BookView view;
+    if (mode == ReadMode::View)
+        book.attachView(&view);
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> nReads{0}, nInconsistent{0};
+    std::vector<std::thread> readers;
+
+    for (size_t r = 0; r < nReaders; ++r)
+        readers.emplace_back([&]{
+            uint64_t reads = 0, inconsistent = 0, lastSequence = 0;
+            LimitLevelInfos bidLevels, askLevels;
+            bidLevels.reserve(BOOK_VIEW_LEVELS);
+            askLevels.reserve(BOOK_VIEW_LEVELS);
+
+            while (!done.load(std::memory_order_relaxed)){
+                if (mode == ReadMode::View){
+                    const BookViewSnapshot snapshot = view.read();
+                    if (!isConsistent(snapshot) || snapshot.sequence < lastSequence)
+                        ++inconsistent;
+                    lastSequence = snapshot.sequence;
+                }
+                else{
+                    (void) book.getTopOfBook();
+                    book.getDepth(Side::Bid, BOOK_VIEW_LEVELS, bidLevels);
+                    book.getDepth(Side::Ask, BOOK_VIEW_LEVELS, askLevels);
+                }
+                ++reads;
+            }
+
+            nReads += reads;
+            nInconsistent += inconsistent;
+        });
+
+    NullListener noListener;
+    const auto start = Clock::now();
+
+    for (const WorkloadCommand& workloadCommand : commands){
+        const OrderCommand& command = workloadCommand.command;
+        switch (command.command){
+            case CommandType::Add:
+                book.addOrder(command.toOrder(), noListener);
+                break;
+            case CommandType::Cancel:
+                book.cancelOrder(command.orderId);
+                break;
+            case CommandType::Amend:
+                book.amendOrder(command.orderId, command.price, command.shares, noListener);
+                break;
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    done = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    // The last publication is the book as it is now
+    if (mode == ReadMode::View){
+        const BookViewSnapshot snapshot = view.read();
+        LimitLevelInfos bidLevels, askLevels;
+        book.getDepth(Side::Bid, BOOK_VIEW_LEVELS, bidLevels);
+        book.getDepth(Side::Ask, BOOK_VIEW_LEVELS, askLevels);
+
+        bool same = bidLevels.size() == snapshot.nBids && askLevels.size() == snapshot.nAsks;
+        for (size_t i = 0; same && i < bidLevels.size(); ++i)
+            same = bidLevels[i].price == snapshot.bids[i].price && bidLevels[i].totalShares == snapshot.bids[i].totalShares;
+        for (size_t i = 0; same && i < askLevels.size(); ++i)
+            same = askLevels[i].price == snapshot.asks[i].price && askLevels[i].totalShares == snapshot.asks[i].totalShares;
+        if (!same)
+            ++nInconsistent;
+    }
+
+    return RunResult{nCommands / seconds, nReads / seconds, nInconsistent.load()};
+}
+
+
+int main(int argc, char* argv[]){
+    const size_t nCommands = (argc > 1) ? std::stoull(argv[1]) : 2000000;
+    const size_t maxReaders = (argc > 2) ? std::stoull(argv[2]) : 8;
+
+    std::cout << nCommands << " commands, " << BOOK_VIEW_LEVELS << " levels per side, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    std::cout << std::setw(8) << "Readers" << std::setw(18) << "Lock: commands/s" << std::setw(16) << "Lock: reads/s"
+              << std::setw(18) << "View: commands/s" << std::setw(16) << "View: reads/s" << std::setw(14) << "Inconsistent" << std::endl;
+
+    for (size_t nReaders = 0; nReaders <= maxReaders; nReaders = (nReaders == 0) ? 1 : 2 * nReaders){
+        const RunResult locked = run(ReadMode::Lock, nCommands, nReaders);
+        const RunResult viewed = run(ReadMode::View, nCommands, nReaders);
+
+        std::cout << std::fixed << std::setprecision(0) << std::setw(8) << nReaders << std::setw(18) << locked.commandsPerSecond
+                  << std::setw(16) << locked.readsPerSecond << std::setw(18) << viewed.commandsPerSecond << std::setw(16) << viewed.readsPerSecond
+                  << std::setw(14) << viewed.nInconsistent << std::endl;
+    }
+}
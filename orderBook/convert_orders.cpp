@@ -0,0 +1,67 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /Fe:convert_orders.exe convert_orders.cpp
+//  execute: ./convert_orders.exe [orders.json] [orders.bin]
+
+/*  Converts an orders.json file (see generate_and_analyze_data) into the binary order file format (see OrderFile.h).
+    Orders get the IDs 1, 2, ... in file order, as when populating the order book from the JSON file.   */
+
+using json = nlohmann::json;
+
+static std::unordered_map<std::string, Type> _map_types = {{"GTC", Type::GTC}, {"FAK", Type::FAK}, {"FOK", Type::FOK}, {"GFD", Type::GFD}, {"M", Type::M}, {"GTT", Type::GTT}};
+static std::unordered_map<std::string, Side> _map_sides = {{"Bid", Side::Bid}, {"Ask", Side::Ask}};
+
+
+int main(int argc, char* argv[]){
+    std::string inputFilename = (argc > 1) ? argv[1] : "orders.json";
+    std::string outputFilename = (argc > 2) ? argv[2] : "orders.bin";
+
+    std::ifstream inputFile(inputFilename);
+    if (!inputFile.is_open()){
+        std::cerr << "Error: Cannot open file " << inputFilename << '\n';
+        return 1;
+    }
+
+    json inputFileOrders;
+    try {
+        inputFile >> inputFileOrders;
+    }
+    catch (const json::parse_error& e){
+        std::cerr << "Error: Failed to parse JSON file. " << e.what() << '\n';
+        return 1;
+    }
+
+    OrderFileWriter writer(outputFilename);
+    uint32_t orderId = 1;
+
+    for (const auto& orderEntry : inputFileOrders){
+        try{
+            Type type = _map_types.at(orderEntry.at("type").get<std::string>());
+            Side side = _map_sides.at(orderEntry.at("side").get<std::string>());
+            Price price = toTicks(orderEntry.at("price").get<double>());
+            uint32_t shares = orderEntry.at("shares");
+
+            Order order(orderId, type, side, price, shares);
+            if (type == Type::GTT)
+                order.setExpiry(orderEntry.at("expiry").get<ExpiryTime>());    // Seconds since the Unix epoch
+            writer.write(order);
+            ++orderId;
+        }
+        catch (const std::exception& e){
+            std::cerr << "Warning: Failed to convert order " << orderId << ". Skipping. " << e.what() << '\n';
+        }
+    }
+
+    writer.close();
+    std::cout << "Converted " << writer.getNumberOfRecords() << " orders from " << inputFilename << " to " << outputFilename << std::endl;
+    return 0;
+}
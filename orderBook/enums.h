@@ -1,16 +1,38 @@
 #pragma once
 
+#include "Price.h"
+
 #include <cstdint>
 
-enum class Type {GTC = 0, FAK, FOK, GFD, M}; // GTC: GoodTillCancel, FAK: FillAndKill, FOK: FillOrKill, GFD: GoodForDay, M: Market
+enum class Type : uint8_t {GTC = 0, FAK, FOK, GFD, M, GTT}; // GTC: GoodTillCancel, FAK: FillAndKill, FOK: FillOrKill, GFD: GoodForDay, M: Market, GTT: GoodTillTime
+
+enum class Side : uint8_t {Bid = 0, Ask};
+
+enum class Action {Add = 0, Remove, Match, Reduce}; // Used to determine how the limit level should be updated (Reduce: an order's size is amended down)
+
+inline const char* toString(Type type){
+    static const char* names[] = {"GTC", "FAK", "FOK", "GFD", "M", "GTT"};
+    return names[static_cast<int>(type)];
+}
 
-enum class Side {Bid = 0, Ask};
+enum class AmendPath : uint8_t {InPlace = 0, Move};   // InPlace: size down at the same price; Move: the order is relinked to its new level
 
-enum class Action {Add = 0, Remove, Match}; // Used to determine how the limit level should be updated
+inline const char* toString(AmendPath path){
+    static const char* names[] = {"in_place", "move"};
+    return names[static_cast<int>(path)];
+}
 
-using Price = double;   // unused
+enum class MarketLeftover : uint8_t {Rest = 0, Cancel};  // What becomes of the shares of a market order left after its sweep
+
+inline const char* toString(Side side) {return (side == Side::Bid) ? "Bid" : "Ask";}
 
 using Quantity = uint32_t;  // ...
 
 using OrderId = uint32_t;   // ...
 
+using SymbolId = uint16_t;  // Identifies the instrument (and thus the order book) an order belongs to
+
+using PoolIndex = uint32_t; // Index of an order in the OrderPool
+
+constexpr PoolIndex NULL_INDEX = UINT32_MAX;   // Used as a null link between orders
+
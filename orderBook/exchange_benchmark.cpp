@@ -0,0 +1,111 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "Exchange.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:exchange_benchmark.exe exchange_benchmark.cpp
+//  execute: ./exchange_benchmark.exe [number of symbols] [number of commands]
+
+/*  Worker scaling benchmark of the Exchange: the same multi-symbol workload is replayed with 1, 2, 4, ... worker threads,
+    and we report the aggregate throughput (commands processed per second, from the first submission until drained).   */
+
+
+std::vector<OrderCommand> generateWorkload(size_t nSymbols, size_t nCommands, uint32_t seed = 42,
+                                            double addProb = 0.6, double cancelProb = 0.2){
+    /* Random adds (mostly GTC around each symbol's mid price), cancellations and amendments of previously added orders */
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> symbolDist(0, nSymbols - 1);
+    std::uniform_real_distribution<> actionDist(0.0, 1.0);
+    std::uniform_int_distribution<int> offsetDist(-50, 50);     // Price offset from the mid price, in ticks
+    std::uniform_int_distribution<uint32_t> sharesDist(1, 500);
+    std::discrete_distribution<int> typeDist({80, 5, 5, 8, 2}); // GTC, FAK, FOK, GFD, M
+
+    Type types[] = {Type::GTC, Type::FAK, Type::FOK, Type::GFD, Type::M};
+    Side sides[] = {Side::Bid, Side::Ask};
+
+    std::vector<OrderId> nextOrderId(nSymbols, 1);
+    std::vector<std::vector<OrderId>> addedIds(nSymbols);
+    const Price midPrice = toTicks(100.0);
+
+    std::vector<OrderCommand> commands;
+    commands.reserve(nCommands);
+
+    while (commands.size() < nCommands){
+        const SymbolId symbol = static_cast<SymbolId>(symbolDist(gen));
+        auto& ids = addedIds[symbol];
+        const double action = actionDist(gen);
+
+        if (ids.empty() || action < addProb){
+            const Type type = types[typeDist(gen)];
+            const Side side = sides[gen() % 2];
+            const OrderId orderId = nextOrderId[symbol]++;
+
+            // Bids mostly below and asks mostly above the mid price, thus the book builds up while some orders cross
+            const Price price = midPrice + offsetDist(gen) + (side == Side::Bid ? -10 : 10);
+            Order order = (type == Type::M) ? Order(orderId, type, side, sharesDist(gen), symbol)
+                                            : Order(orderId, type, side, price, sharesDist(gen), symbol);
+            commands.push_back(OrderCommand::add(order));
+            ids.push_back(orderId);
+        }
+        else{
+            // The order may have been filled in the meantime, in which case the command is a no-op
+            const size_t position = gen() % ids.size();
+            const OrderId orderId = ids[position];
+
+            if (action < addProb + cancelProb){
+                commands.push_back(OrderCommand::cancel(symbol, orderId));
+                ids[position] = ids.back();
+                ids.pop_back();
+            }
+            else
+                commands.push_back(OrderCommand::amend(symbol, orderId, midPrice + offsetDist(gen), sharesDist(gen)));
+        }
+    }
+
+    return commands;
+}
+
+
+int main(int argc, char* argv[]){
+    size_t nSymbols = (argc > 1) ? std::stoul(argv[1]) : 256;
+    size_t nCommands = (argc > 2) ? std::stoul(argv[2]) : 2000000;
+    size_t maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Generating " << nCommands << " commands over " << nSymbols << " symbols..." << std::endl;
+    const auto commands = generateWorkload(nSymbols, nCommands);
+
+    std::cout << "\n" << std::setw(8) << "Workers" << std::setw(16) << "Time (ms)" << std::setw(18) << "Orders/second"
+              << std::setw(10) << "Speedup" << std::setw(12) << "Trades" << std::setw(10) << "Rejected" << std::endl;
+
+    double baselineThroughput = 0.0;
+
+    for (size_t nWorkers = 1; nWorkers <= std::min<size_t>(16, nSymbols); nWorkers *= 2){
+        Exchange exchange(nSymbols, nWorkers, 1 << 14, 2 * nCommands / nSymbols);
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& command : commands)
+            exchange.submit(command);
+        exchange.drain();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const double throughput = exchange.getNumberOfProcessedCommands() / elapsed.count();
+        if (nWorkers == 1)
+            baselineThroughput = throughput;
+
+        std::cout << std::setw(8) << nWorkers
+                  << std::setw(16) << std::fixed << std::setprecision(1) << elapsed.count() * 1e3
+                  << std::setw(18) << std::setprecision(0) << throughput
+                  << std::setw(9) << std::setprecision(2) << throughput / baselineThroughput << "x"
+                  << std::setw(12) << exchange.getNumberOfTrades()
+                  << std::setw(10) << exchange.getNumberOfRejectedCommands()
+                  << (nWorkers > maxWorkers ? "   (more workers than hardware threads)" : "") << std::endl;
+    }
+}
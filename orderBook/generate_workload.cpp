@@ -0,0 +1,167 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+#include "BookFile.cpp"
+#include "Journal.cpp"
+#include "Workload.h"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:generate_workload.exe generate_workload.cpp
+//  execute: ./generate_workload.exe [number of commands] [--out workload.bin] [--seed 42] [--rate 100000] [--cancel 0.40] [--amend 0.15] [--orders 10000]
+//           (default: 10000000 commands, the adds are the rest of the commands, --orders: size of the book the ratios are given for)
+
+/*  Throughput of the workload generator (see Workload.h): generating the commands alone, driving an order book with them
+    (the generator being the book's listener, thus it only targets resting orders), and writing them to a file with --out.
+    The file is a journal (Journal.h, without fsync) whose commands are requests rather than accepted ones:
+    ./replay_journal.exe workload.bin feeds them to a book at their timestamps. Replaces ordersFile.py (MySQL, uniform prices).   */
+
+using Clock = std::chrono::steady_clock;
+
+
+JournalRecord toJournalRecord(const WorkloadCommand& workloadCommand){
+    const OrderCommand& command = workloadCommand.command;
+
+    switch (command.command){
+        case CommandType::Add:
+            return JournalRecord::add(command.toOrder(), workloadCommand.time());
+        case CommandType::Cancel:
+            return JournalRecord::cancel(command.orderId, workloadCommand.time());
+        default:
+            return JournalRecord::amend(command.orderId, command.price, command.shares, workloadCommand.time());
+    }
+}
+
+
+void report(const char* mode, size_t nCommands, double seconds){
+    std::cout << std::setw(12) << mode << std::fixed << std::setprecision(3) << std::setw(12) << seconds
+              << std::setprecision(1) << std::setw(14) << 1e9 * seconds / nCommands
+              << std::setprecision(0) << std::setw(16) << nCommands / seconds << std::endl;
+}
+
+
+int main(int argc, char* argv[]){
+    size_t nCommands = 10000000;
+    std::string outFilename;
+    WorkloadOptions options;
+
+    try{
+        int i = 1;
+        if (argc > 1 && argv[1][0] != '-')
+            nCommands = std::stoull(argv[i++]);
+
+        for (; i < argc; ++i){
+            const std::string argument = argv[i];
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value of " + argument);
+
+            if (argument == "--out")
+                outFilename = argv[++i];
+            else if (argument == "--seed")
+                options.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+            else if (argument == "--rate")
+                options.arrivalRate = std::stod(argv[++i]);
+            else if (argument == "--cancel")
+                options.cancelRatio = std::stod(argv[++i]);
+            else if (argument == "--amend")
+                options.amendRatio = std::stod(argv[++i]);
+            else if (argument == "--orders")
+                options.bookSize = std::stoull(argv[++i]);
+            else
+                throw std::invalid_argument("Unknown argument " + argument);
+        }
+
+        options.addRatio = 1.0 - options.cancelRatio - options.amendRatio;
+        if (options.addRatio <= 0.0 || options.cancelRatio < 0.0 || options.amendRatio < 0.0 || options.arrivalRate <= 0.0)
+            throw std::invalid_argument("The cancel & amend ratios must be positive and sum below 1, the rate must be positive");
+    }
+    catch (const std::exception& e){
+        std::cerr << "Error: " << e.what() << '\n'
+                  << "Usage: " << argv[0] << " [number of commands] [--out workload.bin] [--seed 42] [--rate 100000] [--cancel 0.40] [--amend 0.15] [--orders 10000]" << std::endl;
+        return 1;
+    }
+
+    std::cout << nCommands << " commands, seed " << options.seed << ", " << options.arrivalRate << " commands/s, "
+              << options.addRatio << " adds / " << options.cancelRatio << " cancels / " << options.amendRatio << " amends at " << options.bookSize << " orders" << std::endl;
+    std::cout << std::setw(12) << "Mode" << std::setw(12) << "Time (s)" << std::setw(14) << "ns/command" << std::setw(16) << "Commands/s" << std::endl;
+
+    // Generation alone: the commands are folded into a sum, thus they can't be optimized away
+    {
+        WorkloadGenerator generator(options);
+        uint64_t sum = 0;
+
+        const auto start = Clock::now();
+        for (size_t i = 0; i < nCommands; ++i){
+            const WorkloadCommand command = generator.next();
+            sum += command.command.orderId + command.command.price;
+        }
+        report("Generate", nCommands, std::chrono::duration<double>(Clock::now() - start).count());
+
+        if (sum == 0)
+            std::cout << "Empty workload" << std::endl;
+    }
+
+    // Into an order book, on the clock of the commands
+    {
+        WorkloadGenerator generator(options);
+        ManualWallClock clock(options.start);
+        OrderBook book(0, LogVerbosity::Silent, false, clock);
+
+        const auto start = Clock::now();
+        for (size_t i = 0; i < nCommands; ++i){
+            const WorkloadCommand workloadCommand = generator.next();
+            const OrderCommand& command = workloadCommand.command;
+            clock.set(workloadCommand.time());
+
+            switch (command.command){
+                case CommandType::Add:
+                    book.addOrder(command.toOrder(), generator);
+                    break;
+                case CommandType::Cancel:
+                    book.cancelOrder(command.orderId);
+                    break;
+                case CommandType::Amend:
+                    book.amendOrder(command.orderId, command.price, command.shares, generator);
+                    break;
+            }
+        }
+        report("Order book", nCommands, std::chrono::duration<double>(Clock::now() - start).count());
+
+        std::cout << "    Resting orders: " << book.getNumberOfOrders() << " (" << generator.getNumberOfLiveOrders()
+                  << " tracked by the generator), mid " << std::setprecision(2) << toDecimalPrice(generator.getMid()) << std::endl;
+    }
+
+    if (!outFilename.empty()){
+        try{
+            std::remove(outFilename.c_str());   // A new workload, not the continuation of an existing journal
+
+            WorkloadGenerator generator(options);
+            JournalOptions journalOptions;
+            journalOptions.sync = false;
+            journalOptions.batchRecords = 1 << 16;
+
+            const auto start = Clock::now();
+            {
+                JournalWriter journal(outFilename, journalOptions);
+                for (size_t i = 0; i < nCommands; ++i)
+                    journal.append(toJournalRecord(generator.next()));
+            }   // Written once the writer is destroyed
+            report("File", nCommands, std::chrono::duration<double>(Clock::now() - start).count());
+
+            std::cout << "    Written to " << outFilename << std::endl;
+        }
+        catch (const std::exception& e){
+            std::cerr << "Error: " << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+#include "BookFile.cpp"
+#include "Journal.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:journal_benchmark.exe journal_benchmark.cpp
+//  execute: ./journal_benchmark.exe [number of commands]     (default: 1000000)
+
+/*  Cost of journaling the commands of a seeded workload (adds of every type, market orders, cancels, amends & expiries),
+    per command, without journal vs with a journal written in batches with & without fsync (group commit). The journal
+    is then replayed into an empty book (see replayJournal): the trades & the book (its snapshot) must be identical.
+    The book runs on a ManualWallClock moved by the workload, thus every run makes the same decisions.   */
+
+using Clock = std::chrono::steady_clock;
+
+
+class ExecutionRecorder : public ExecutionListener<ExecutionRecorder>{
+public:
+    std::vector<Execution> executions;
+
+    void onExecution(const Execution& execution) {executions.push_back(execution);}
+};
+
+
+bool sameExecutions(const std::vector<Execution>& executions, const std::vector<Execution>& otherExecutions){
+    return std::equal(executions.begin(), executions.end(), otherExecutions.begin(), otherExecutions.end(),
+                        [](const Execution& a, const Execution& b){
+                            return a.bidOrderId == b.bidOrderId && a.askOrderId == b.askOrderId && a.bidPrice == b.bidPrice
+                                    && a.askPrice == b.askPrice && a.shares == b.shares && a.aggressor == b.aggressor;
+                        });
+}
+
+
+std::vector<JournalRecord> generateCommands(size_t nCommands, std::chrono::system_clock::time_point start, uint32_t seed = 42){
+    /*  The workload, as the journal records of the commands (without sequence): prices around a mid price moving at random,
+        cancels & amends of orders drawn from the ones added so far (filled or cancelled ones are unknown to the book).
+        The commands are 100µs apart, thus the GTT orders (1 to 60s) expire during the run.   */
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> actionDist(0.0, 1.0);
+    std::geometric_distribution<Price> distanceDist(0.1);
+    std::uniform_int_distribution<Quantity> sharesDist(1, 100);
+    std::uniform_int_distribution<int> stepDist(-1, 1);
+    std::uniform_int_distribution<ExpiryTime> lifetimeDist(1, 60);
+
+    std::vector<JournalRecord> commands;
+    commands.reserve(nCommands);
+    std::vector<OrderId> addedOrders;
+    addedOrders.reserve(nCommands);
+
+    Price mid = toTicks(30.0);
+    OrderId nextOrderId = 1;
+
+    for (size_t i = 0; i < nCommands; ++i){
+        const auto time = start + std::chrono::microseconds(100 * i);
+        const double action = actionDist(gen);
+        const Side side = (gen() % 2) ? Side::Bid : Side::Ask;
+        mid = std::max<Price>(1000, mid + stepDist(gen));
+
+        // Passive orders away from the mid, some aggressive ones through it
+        auto limitPrice = [&]{
+            const Price distance = distanceDist(gen) - ((gen() % 8 == 0) ? 5 : 0);
+            return (side == Side::Bid) ? mid - distance : mid + distance;
+        };
+
+        if (action < 0.40 || addedOrders.empty()){
+            const double kind = actionDist(gen);
+            const Type type = (kind < 0.70) ? Type::GTC : (kind < 0.80) ? Type::GFD : (kind < 0.90) ? Type::GTT : (kind < 0.95) ? Type::FAK : Type::FOK;
+
+            Order order(nextOrderId, type, side, limitPrice(), sharesDist(gen));
+            if (type == Type::GTT)
+                order.setExpiry(toExpiryTime(time) + lifetimeDist(gen));
+            commands.push_back(JournalRecord::add(order, time));
+            addedOrders.push_back(nextOrderId++);
+        }
+        else if (action < 0.43){
+            const Price protectionPrice = (gen() % 2) ? limitPrice() : 0;
+            const MarketLeftover leftover = (gen() % 2) ? MarketLeftover::Rest : MarketLeftover::Cancel;
+            commands.push_back(JournalRecord::add(Order(nextOrderId, Type::M, side, sharesDist(gen)), time, protectionPrice, leftover));
+            addedOrders.push_back(nextOrderId++);
+        }
+        else if (action < 0.73)
+            commands.push_back(JournalRecord::cancel(addedOrders[gen() % addedOrders.size()], time));
+        else
+            commands.push_back(JournalRecord::amend(addedOrders[gen() % addedOrders.size()], limitPrice(), sharesDist(gen), time));
+    }
+
+    return commands;
+}
+
+
+template<typename Listener>
+double runCommands(const std::vector<JournalRecord>& commands, OrderBook& book, ManualWallClock& clock, ExecutionListener<Listener>& listener){
+    /* Apply the commands through the order book API, expiring the due orders every 1000 commands. Returns the time in ms */
+    constexpr size_t EXPIRY_PERIOD = 1000;
+
+    const auto start = Clock::now();
+
+    for (size_t i = 0; i < commands.size(); ++i){
+        const JournalRecord& command = commands[i];
+        clock.set(command.time());
+
+        switch (command.entry){
+            case JournalEntry::Add:
+                if (command.type == Type::M)
+                    book.addMarketOrder(command.toOrder(), command.price, command.leftover, listener);
+                else
+                    book.addOrder(command.toOrder(), listener);
+                break;
+            case JournalEntry::Cancel:
+                book.cancelOrder(command.orderId);
+                break;
+            case JournalEntry::Amend:
+                book.amendOrder(command.orderId, command.price, command.shares, listener);
+                break;
+            default:
+                break;
+        }
+
+        if (i % EXPIRY_PERIOD == EXPIRY_PERIOD - 1)
+            while (book.expireOrders() > 0);
+    }
+
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+
+int main(int argc, char* argv[]){
+    const size_t nCommands = (argc > 1) ? std::stoull(argv[1]) : 1000000;
+
+    const std::string journalFilename = "journal_benchmark.bin";
+    const std::string snapshotFilename = "journal_benchmark_book.bin";
+    const std::string replayedSnapshotFilename = "journal_benchmark_replayed_book.bin";
+
+    const auto sessionStart = fromExpiryTime(1767605400);   // 2026-01-05 09:30 UTC, fixed thus every run is the same
+    const std::vector<JournalRecord> commands = generateCommands(nCommands, sessionStart);
+
+    struct Mode{
+        const char* name;
+        bool journaled;
+        bool sync;
+    };
+    const Mode modes[] = {{"No journal", false, false}, {"Journal, no fsync", true, false}, {"Journal + fsync", true, true}};
+
+    std::cout << "Price levels backend: " << PRICE_LEVELS_BACKEND << ", " << nCommands << " commands" << std::endl;
+    std::cout << std::setw(20) << "Mode" << std::setw(12) << "Time (ms)" << std::setw(14) << "ns/command" << std::setw(14) << "Overhead (ns)"
+              << std::setw(10) << "Batches" << std::setw(16) << "Records/batch" << std::setw(16) << "Write+sync (ms)" << std::endl;
+
+    constexpr int REPETITIONS = 3;  // Best time of each mode, the runs being noisy
+
+    double baseline = 0.0;
+    ExecutionRecorder originalTrades;
+
+    for (const Mode& mode : modes){
+        JournalStats stats;
+        double time = 0.0;
+
+        for (int repetition = 0; repetition < REPETITIONS; ++repetition){
+            std::remove(journalFilename.c_str());
+
+            ManualWallClock clock(sessionStart);
+            OrderBook book(nCommands, LogVerbosity::Silent, false, clock);
+            ExecutionRecorder recorder;
+            recorder.executions.reserve(nCommands);
+
+            JournalStats runStats;
+            double runTime;
+            if (mode.journaled){
+                JournalOptions options;
+                options.sync = mode.sync;
+                JournalWriter journal(journalFilename, options);
+
+                book.attachJournal(&journal);
+                runTime = runCommands(commands, book, clock, recorder);
+                book.attachJournal(nullptr);
+
+                journal.flush();
+                runStats = journal.getStats();
+            }
+            else
+                runTime = runCommands(commands, book, clock, recorder);
+
+            if (repetition == 0 || runTime < time){
+                time = runTime;
+                stats = runStats;
+            }
+
+            if (mode.sync && repetition == REPETITIONS - 1){    // The journal of the last run is replayed
+                book.saveSnapshot(snapshotFilename);
+                originalTrades.executions.swap(recorder.executions);
+            }
+        }
+
+        if (!mode.journaled)
+            baseline = time;
+
+        const double perCommand = 1e6 * time / nCommands;
+        std::cout << std::setw(20) << mode.name << std::fixed << std::setprecision(1) << std::setw(12) << time << std::setw(14) << perCommand
+                  << std::setw(14) << (mode.journaled ? perCommand - 1e6 * baseline / nCommands : 0.0);
+        if (mode.journaled)
+            std::cout << std::setw(10) << stats.nBatches << std::setw(16) << static_cast<double>(stats.nRecords) / std::max<uint64_t>(stats.nBatches, 1)
+                      << std::setw(16) << stats.syncTime;
+        std::cout << std::endl;
+    }
+
+    // Replay of the journal into an empty book
+    ManualWallClock clock(sessionStart);
+    OrderBook replayed(nCommands, LogVerbosity::Silent, false, clock);
+    ExecutionRecorder replayedTrades;
+    replayedTrades.executions.reserve(originalTrades.executions.size());
+
+    const auto start = Clock::now();
+    const JournalReplayResult result = replayJournal(journalFilename, replayed, clock, replayedTrades);
+    const double replayTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    replayed.saveSnapshot(replayedSnapshotFilename);
+
+    std::cout << "\nReplay: " << result.nRecords << " records (" << nCommands << " commands, the unknown cancels & amends aren't journaled) in "
+              << std::setprecision(1) << replayTime << " ms, " << std::setprecision(0) << 1e3 * result.nRecords / replayTime << " records/s" << '\n'
+              << "    Trades:      " << replayedTrades.executions.size() << " (" << (sameExecutions(originalTrades.executions, replayedTrades.executions) ? "identical" : "DIFFERENT") << ")" << '\n'
+              << "    Book:        " << replayed.getNumberOfOrders() << " resting orders (" << (sameFileContents(snapshotFilename, replayedSnapshotFilename) ? "identical" : "DIFFERENT") << ")"
+              << std::endl;
+
+    std::remove(journalFilename.c_str());
+    std::remove(snapshotFilename.c_str());
+    std::remove(replayedSnapshotFilename.c_str());
+}
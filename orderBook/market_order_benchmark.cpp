@@ -0,0 +1,78 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:market_order_benchmark.exe market_order_benchmark.cpp
+//  execute: ./market_order_benchmark.exe [number of iterations]     (default: 20000)
+
+/*  Latency of a market buy order sweeping the asks:
+        - sweep: the native path (addOrder of a Type::M order), the order consumes the asks without being inserted in the book
+        - GTC at worst: the previous path, i.e. a GTC order at the worst ask price inserted in the book then matched
+    The asks are nLevels levels of one 10-share order each, rebuilt before every (timed) order, and the market order takes
+    one level partially, 5 levels, or every level with 5 shares left over (which rest in the book with both paths).   */
+
+using Clock = std::chrono::steady_clock;
+
+
+void fillAsks(OrderBook& orderBook, size_t nLevels, std::vector<Order>& asks){
+    asks.clear();
+    for (size_t level = 0; level < nLevels; ++level)
+        asks.emplace_back(static_cast<OrderId>(level + 1), Type::GTC, Side::Ask, static_cast<Price>(3001 + level), 10u);
+
+    NullListener noListener;
+    orderBook.addOrders(asks, noListener);
+}
+
+
+LatencyHistogram timeOrders(size_t nIterations, size_t nLevels, Quantity shares, bool nativeSweep){
+    LatencyHistogram latencies;
+    std::vector<Order> asks;
+    asks.reserve(nLevels);
+    TradeCounter tradeCounter;
+
+    for (size_t i = 0; i < nIterations; ++i){
+        OrderBook orderBook(nLevels + 1, LogVerbosity::Silent, false);
+        fillAsks(orderBook, nLevels, asks);
+
+        const OrderId orderId = static_cast<OrderId>(nLevels + 1);
+        const Order order = nativeSweep ? Order(orderId, Type::M, Side::Bid, shares)
+                                        : Order(orderId, Type::GTC, Side::Bid, static_cast<Price>(3000 + nLevels), shares);
+
+        auto start = Clock::now();
+        orderBook.addOrder(order, tradeCounter);
+        latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+
+    return latencies;
+}
+
+
+int main(int argc, char* argv[]){
+    const size_t nIterations = (argc > 1) ? std::stoull(argv[1]) : 20000;
+
+    std::cout << std::setw(8) << "Levels" << std::setw(10) << "Swept" << std::setw(16) << "Path"
+              << std::setw(12) << "p50 (ns)" << std::setw(12) << "p99 (ns)" << std::setw(12) << "Mean (ns)" << std::endl;
+
+    for (size_t nLevels : {10, 100}){
+        const std::vector<std::pair<std::string, Quantity>> cases = {
+            {"partial", 5}, {"5 levels", 50}, {"all+rest", static_cast<Quantity>(nLevels * 10 + 5)}
+        };
+
+        for (const auto& sweepCase : cases){
+            for (bool nativeSweep : {false, true}){
+                const LatencyHistogram latencies = timeOrders(nIterations, nLevels, sweepCase.second, nativeSweep);
+
+                std::cout << std::setw(8) << nLevels << std::setw(10) << sweepCase.first << std::setw(16) << (nativeSweep ? "sweep" : "GTC at worst")
+                          << std::setw(12) << latencies.percentile(50.0) << std::setw(12) << latencies.percentile(99.0)
+                          << std::setw(12) << std::fixed << std::setprecision(0) << latencies.mean() << std::endl;
+            }
+        }
+    }
+}
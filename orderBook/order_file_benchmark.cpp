@@ -0,0 +1,151 @@
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:order_file_benchmark.exe order_file_benchmark.cpp
+//  execute: ./order_file_benchmark.exe [--scan-only] [number of orders...]     (default: 60000 10000000 100000000)
+
+/*  Load time of the binary order file format, for files of increasing size (generated once as orders_<n>.bin):
+        - scan: map the file and decode every record into an Order, without a book (bounded by the disk/page cache)
+        - book: loadOrderFile into an empty OrderBook (skipped with --scan-only, 100M resting orders need several GB)
+    If orders.json is in the current directory, the JSON loader of test.cpp (DOM + string lookups) is timed as well.   */
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+static std::unordered_map<std::string, Type> _map_types = {{"GTC", Type::GTC}, {"FAK", Type::FAK}, {"FOK", Type::FOK}, {"GFD", Type::GFD}, {"M", Type::M}};
+static std::unordered_map<std::string, Side> _map_sides = {{"Bid", Side::Bid}, {"Ask", Side::Ask}};
+
+
+double secondsSince(Clock::time_point start) {return std::chrono::duration<double>(Clock::now() - start).count();}
+
+
+void generateOrderFile(const std::string& filename, size_t nOrders, uint32_t seed = 42){
+    /* Same distributions as generate_and_analyze_data: prices around 30.00, 5 order types, both sides */
+    std::mt19937 gen(seed);
+    std::normal_distribution<> priceDist(30.0, 10.0);
+    std::normal_distribution<> sharesDist(50.0, 50.0);
+    Type types[] = {Type::GTC, Type::FAK, Type::FOK, Type::GFD, Type::M};
+
+    OrderFileWriter writer(filename);
+    for (size_t i = 1; i <= nOrders; ++i){
+        OrderRecord record{};
+        record.timestamp = i * 1000;    // One order per microsecond
+        record.orderId = static_cast<OrderId>(i);
+        record.type = types[gen() % 5];
+        record.side = (gen() % 2) ? Side::Bid : Side::Ask;
+        record.price = toTicks(std::max(0.01, priceDist(gen)));
+        record.shares = static_cast<Quantity>(std::max(5.0, sharesDist(gen)));
+        writer.write(record);
+    }
+}
+
+
+void timeJsonLoad(const std::string& filename){
+    /* The JSON loading path of test.cpp: parse the whole file into a DOM, then look up the type & side strings */
+    std::ifstream inputFile(filename);
+    if (!inputFile.is_open())
+        return;
+
+    auto start = Clock::now();
+    json inputFileOrders;
+    inputFile >> inputFileOrders;
+
+    std::vector<Order> orders;
+    uint32_t orderId = 1;
+    for (const auto& orderEntry : inputFileOrders)
+        orders.emplace_back(orderId++, _map_types[orderEntry.at("type").get<std::string>()], _map_sides[orderEntry.at("side").get<std::string>()],
+                            toTicks(orderEntry.at("price").get<double>()), orderEntry.at("shares").get<uint32_t>());
+    double parseTime = secondsSince(start);
+
+    OrderBook orderBook(0, LogVerbosity::Silent, false);
+    NullListener noListener;
+    orderBook.addOrders(orders, noListener);
+    double totalTime = secondsSince(start);
+
+    std::cout << std::setw(12) << orders.size() << std::setw(14) << "json"
+              << std::setw(14) << std::fixed << std::setprecision(2) << parseTime * 1e3
+              << std::setw(14) << totalTime * 1e3 << std::setw(16) << std::setprecision(0) << orders.size() / totalTime << std::endl;
+}
+
+
+int main(int argc, char* argv[]){
+    bool scanOnly = false;
+    std::vector<size_t> sizes;
+
+    for (int i = 1; i < argc; ++i){
+        std::string argument = argv[i];
+        if (argument == "--scan-only")
+            scanOnly = true;
+        else
+            sizes.push_back(std::stoull(argument));
+    }
+    if (sizes.empty())
+        sizes = {60000, 10000000, 100000000};
+
+    std::cout << std::setw(12) << "Orders" << std::setw(14) << "Format" << std::setw(14) << "Scan (ms)"
+              << std::setw(14) << "Book (ms)" << std::setw(16) << "Orders/second" << std::endl;
+
+    timeJsonLoad("orders.json");
+
+    for (size_t nOrders : sizes){
+        const std::string filename = "orders_" + std::to_string(nOrders) + ".bin";
+
+        try{
+            OrderFileReader existing(filename);
+            if (existing.size() != nOrders)
+                throw std::runtime_error("Wrong size");
+        }
+        catch (const std::runtime_error&){
+            auto start = Clock::now();
+            generateOrderFile(filename, nOrders);
+            std::cerr << "(generated " << filename << " in " << secondsSince(start) << " s)" << std::endl;
+        }
+
+        // Decode every record, the checksum keeps the compiler from skipping the work
+        auto start = Clock::now();
+        uint64_t checksum = 0;
+        {
+            OrderFileReader reader(filename);
+            for (const OrderRecord& record : reader){
+                try{
+                    const Order order = record.toOrder();
+                    checksum += order.getOrderPrice() + order.getOrderShares();
+                }
+                catch (const std::invalid_argument&) {}
+            }
+        }
+        double scanTime = secondsSince(start);
+
+        double bookTime = 0.0;
+        if (!scanOnly){
+            OrderBook orderBook(0, LogVerbosity::Silent, false);
+            start = Clock::now();
+            (void) loadOrderFile(filename, orderBook);
+            bookTime = secondsSince(start);
+        }
+
+        std::ostringstream bookColumn;
+        if (scanOnly)
+            bookColumn << "-";
+        else
+            bookColumn << std::fixed << std::setprecision(2) << bookTime * 1e3;
+
+        std::cout << std::setw(12) << nOrders << std::setw(14) << "binary"
+                  << std::setw(14) << std::fixed << std::setprecision(2) << scanTime * 1e3
+                  << std::setw(14) << bookColumn.str()
+                  << std::setw(16) << std::setprecision(0) << nOrders / (scanOnly ? scanTime : bookTime)
+                  << "   (checksum " << checksum << ")" << std::endl;
+    }
+}
@@ -0,0 +1,207 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "Sequencer.cpp"
+#include "Workload.h"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /Fe:pinned_sequencer_benchmark.exe pinned_sequencer_benchmark.cpp
+//  execute: ./pinned_sequencer_benchmark.exe [number of commands] [--rate 100000] [--client-core 0] [--matching-core 3] [--housekeeping-core 2] [--fifo] [--mlock]
+//           (default: 1000000 commands, cores taken from the last ones of the machine, -1: not pinned. --fifo: SCHED_FIFO, needs CAP_SYS_NICE)
+
+/*  Tail latency of the sequencer in its shared mode vs its pinned run mode (see SequencerOptions). One client submits a seeded
+    workload (Workload.h) open loop at --rate commands per second, 10% of the adds being GTT orders expiring one second later,
+    thus orders keep expiring during the run. Latency = time from the command's scheduled send time (not its actual one, thus
+    a stalled client doesn't hide the queueing behind it) until its final report. Modes:
+        - shared: default options, the matching thread yields when idle and expires the orders itself
+        - pinned: the matching thread pinned to its core, busy-polling, expiring the orders itself
+        - pinned + housekeeping: the expiries requested and the statistics exported (every 100 ms) by a housekeeping
+          thread pinned to another core (sequencer_stats.json)
+    The pinned modes need dedicated cores: with less than 3 hardware threads the busy-polling matching thread shares a core with
+    the client, which then measures the OS scheduler.   */
+
+using Clock = std::chrono::steady_clock;
+
+constexpr double GTT_RATIO = 0.10;     // Share of the GTC adds turned into GTT orders
+constexpr ExpiryTime GTT_LIFETIME = 1; // Seconds
+
+
+struct RunResult{
+    double seconds;
+    LatencyHistogram latencies;
+    uint64_t nRejected;
+};
+
+
+RunResult run(const std::vector<WorkloadCommand>& workload, const SequencerOptions& options, const ThreadPlacement& clientPlacement, std::string& tuningErrors){
+    Sequencer sequencer(options);
+    tuningErrors = sequencer.getTuningErrors();
+    const ClientId client = sequencer.registerClient();
+
+    RunResult result{0.0, LatencyHistogram{}, 0};
+    std::thread clientThread([&]{
+        const size_t nCommands = workload.size();
+        const int64_t firstTimestamp = workload.front().timestamp;
+        WorkloadRandom gen(7);
+        std::vector<Clock::time_point> sendTimes(nCommands);    // Scheduled ones
+
+        size_t nSubmitted = 0, nDone = 0;
+        ExecutionReport executionReport;
+        const auto start = Clock::now();
+
+        while (nDone < nCommands){
+            const size_t nBefore = nSubmitted + nDone;
+            const auto now = Clock::now();
+            while (nSubmitted < nCommands){
+                const auto sendTime = start + std::chrono::nanoseconds(workload[nSubmitted].timestamp - firstTimestamp);
+                if (sendTime > now)
+                    break;
+
+                OrderCommand command = workload[nSubmitted].command;
+                if (command.command == CommandType::Add && command.type == Type::GTC && gen.unit() < GTT_RATIO){
+                    command.type = Type::GTT;
+                    command.expiry = toExpiryTime(std::chrono::system_clock::now()) + GTT_LIFETIME;
+                }
+
+                sendTimes[nSubmitted] = sendTime;
+                if (!sequencer.trySubmit(client, nSubmitted, command))
+                    break;  // The queue is full, the command is late from now on
+                ++nSubmitted;
+            }
+
+            while (sequencer.tryPoll(client, executionReport))
+                if (executionReport.type != ReportType::Trade){    // Final report of the command
+                    result.latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - sendTimes[executionReport.requestId]).count());
+                    result.nRejected += executionReport.type == ReportType::Rejected;
+                    ++nDone;
+                }
+
+            // Nothing to do until the next send time: on a core of its own yielding returns at once, otherwise it lets the matching thread run
+            if (nSubmitted + nDone == nBefore)
+                std::this_thread::yield();
+        }
+
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    });
+
+    tuningErrors += placeThread(clientThread, clientPlacement);
+    clientThread.join();
+
+    if (!options.statsFilename.empty() && !sequencer.getStatsFailure().empty())
+        tuningErrors += sequencer.getStatsFailure();
+    return result;
+}
+
+
+int main(int argc, char* argv[]){
+    size_t nCommands = 1000000;
+    WorkloadOptions workloadOptions;
+    const int nCores = static_cast<int>(std::thread::hardware_concurrency());
+    ThreadPlacement clientPlacement, matchingPlacement, housekeepingPlacement;
+    bool realtime = false, lockMemory = false;
+
+    if (nCores >= 3){
+        clientPlacement.core = 0;   // The usual isolated cores are the last ones
+        housekeepingPlacement.core = nCores - 2;
+        matchingPlacement.core = nCores - 1;
+    }
+
+    try{
+        int i = 1;
+        if (argc > 1 && argv[1][0] != '-')
+            nCommands = std::stoull(argv[i++]);
+
+        for (; i < argc; ++i){
+            const std::string argument = argv[i];
+            if (argument == "--fifo")
+                realtime = true;
+            else if (argument == "--mlock")
+                lockMemory = true;
+            else if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value of " + argument);
+            else if (argument == "--rate")
+                workloadOptions.arrivalRate = std::stod(argv[++i]);
+            else if (argument == "--client-core")
+                clientPlacement.core = std::stoi(argv[++i]);
+            else if (argument == "--matching-core")
+                matchingPlacement.core = std::stoi(argv[++i]);
+            else if (argument == "--housekeeping-core")
+                housekeepingPlacement.core = std::stoi(argv[++i]);
+            else
+                throw std::invalid_argument("Unknown argument " + argument);
+        }
+
+        if (nCommands == 0 || workloadOptions.arrivalRate <= 0.0)
+            throw std::invalid_argument("The number of commands and the rate must be positive");
+    }
+    catch (const std::exception& e){
+        std::cerr << "Error: " << e.what() << '\n'
+                  << "Usage: " << argv[0] << " [number of commands] [--rate 100000] [--client-core 0] [--matching-core 3] [--housekeeping-core 2] [--fifo] [--mlock]" << std::endl;
+        return 1;
+    }
+
+    if (realtime && nCores < 3){
+        realtime = false;   // A busy-polling SCHED_FIFO thread would starve the client of its only core
+        std::cout << "Only " << nCores << " hardware threads, --fifo is ignored" << std::endl;
+    }
+
+    WorkloadGenerator generator(workloadOptions);
+    std::vector<WorkloadCommand> workload(nCommands);
+    for (auto& command : workload)
+        command = generator.next();
+
+    SequencerOptions shared;
+    shared.maxClients = 1;
+    shared.expectedOrders = workloadOptions.bookSize * 2;
+
+    SequencerOptions pinned = shared;
+    pinned.matching = matchingPlacement;
+    pinned.matching.realtime = realtime;
+    pinned.backoff = IdleBackoff::busyPoll();
+    pinned.lockMemory = lockMemory;
+
+    SequencerOptions housekept = pinned;
+    housekept.housekeeping = true;
+    housekept.housekeeper = housekeepingPlacement;
+    housekept.statsFilename = "sequencer_stats.json";
+    housekept.statsInterval = std::chrono::milliseconds(100);
+
+    std::cout << nCommands << " commands at " << workloadOptions.arrivalRate << " commands/s, " << nCores << " hardware threads, cores: client "
+              << clientPlacement.core << ", matching " << matchingPlacement.core << ", housekeeping " << housekeepingPlacement.core
+              << (realtime ? ", SCHED_FIFO" : "") << (lockMemory ? ", mlockall" : "") << std::endl;
+    std::cout << std::setw(24) << "Mode" << std::setw(12) << "p50 (μs)" << std::setw(12) << "p99 (μs)" << std::setw(14) << "p99.9 (μs)"
+              << std::setw(14) << "p99.99 (μs)" << std::setw(12) << "max (μs)" << std::setw(12) << "Rejected" << std::endl;
+
+    struct Mode{
+        const char* name;
+        SequencerOptions options;
+        ThreadPlacement client;
+    };
+
+    std::string errors;
+    for (const Mode& mode : {Mode{"shared", shared, ThreadPlacement{}}, Mode{"pinned", pinned, clientPlacement}, Mode{"pinned + housekeeping", housekept, clientPlacement}}){
+        std::string tuningErrors;
+        const RunResult result = run(workload, mode.options, mode.client, tuningErrors);
+        const LatencyHistogram& latencies = result.latencies;
+
+        std::cout << std::setw(24) << mode.name << std::fixed << std::setprecision(2) << std::setw(12) << latencies.percentile(50.0) / 1e3
+                  << std::setw(12) << latencies.percentile(99.0) / 1e3 << std::setw(14) << latencies.percentile(99.9) / 1e3
+                  << std::setw(14) << latencies.percentile(99.99) / 1e3 << std::setw(12) << latencies.max() / 1e3
+                  << std::setw(12) << result.nRejected << std::endl;
+        if (!tuningErrors.empty())
+            errors += std::string(mode.name) + ": " + tuningErrors + "\n";
+    }
+    std::cout << "Statistics of the last run exported to " << housekept.statsFilename << std::endl;
+
+    if (!errors.empty())
+        std::cout << "\nNot applied (the run went on without it):\n" << errors;
+    if (nCores < 3)
+        std::cout << "\nNote: only " << nCores << " hardware threads, the pinned modes share their cores with the client" << std::endl;
+    return 0;
+}
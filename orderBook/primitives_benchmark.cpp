@@ -0,0 +1,416 @@
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:primitives_benchmark.exe primitives_benchmark.cpp /link /LIBPATH:"C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/lib" benchmark.lib shlwapi.lib
+//  execute: ./primitives_benchmark.exe [--sizes=1000,10000,100000,1000000,10000000] [Google Benchmark flags, e.g. --benchmark_filter=Cancel]
+
+/*  Google Benchmark suite of the order book primitives, each timed on its own at book sizes from 1k to 10M resting orders:
+        - AddExistingLevel / AddNewLevel: GTC order resting at a price that has a level, or a new level inside the spread
+        - CancelHead / CancelMiddle / CancelTail: cancel of the order at that position of its level
+        - AmendInPlace (size down, keeps its priority) / AmendMove (to another level)
+        - Match/depth: aggressive order consuming depth levels (4 orders each)
+        - FOKCheck/depth: FOK order that can't be filled by the first depth levels, thus only the feasibility check runs
+        - GFDSweep: expiry at the close of the GFD orders (10% of the book), per expired order
+    The book of each size is built once, from a fixed seed: nLevels levels per side (1000, fewer for small books) holding
+    the same number of orders. Each iteration times a batch of operations, which is then undone (untimed), thus every
+    iteration runs on the same book. ns/op is the time of one operation, without the undo nor the clock reads per operation.   */
+
+using Clock = std::chrono::steady_clock;
+
+constexpr Price MID_PRICE = 10000;     // 100.00
+constexpr Price HALF_SPREAD = 64;      // Best bid at MID_PRICE - 64, best ask at MID_PRICE + 64: room for new levels inside the spread
+constexpr size_t MAX_LEVELS = 1000;
+constexpr Quantity ORDER_SHARES = 100;
+constexpr size_t BATCH = 256;          // Operations per iteration
+
+
+// A book of nOrders resting orders, and the order IDs of each bid level in time priority (cancels & amends target bids)
+struct BenchmarkBook{
+    const size_t nOrders;
+    const size_t nLevels;
+    const size_t ordersPerLevel;
+    const std::chrono::system_clock::time_point sessionTime = fromExpiryTime(1767605400);    // Fixed, thus GFD orders always expire at the same close
+
+    ManualWallClock clock{sessionTime};
+    OrderBook book;
+    std::vector<std::deque<OrderId>> bidQueues;
+    OrderId nextOrderId = 1;
+    std::mt19937 gen;
+
+    explicit BenchmarkBook(size_t _nOrders, uint32_t seed = 42)
+    : nOrders(_nOrders), nLevels(std::clamp<size_t>(_nOrders / 8, 1, MAX_LEVELS)), ordersPerLevel(std::max<size_t>(_nOrders / 2 / nLevels, 1)),
+      book(2 * nLevels * ordersPerLevel + 4 * BATCH, LogVerbosity::Silent, false, clock), bidQueues(nLevels), gen(seed){
+        std::vector<Order> orders;
+        orders.reserve(2 * nLevels * ordersPerLevel);
+        for (size_t level = 0; level < nLevels; ++level)
+            for (size_t k = 0; k < ordersPerLevel; ++k){
+                bidQueues[level].push_back(nextOrderId);
+                orders.emplace_back(nextOrderId++, Type::GTC, Side::Bid, bidPrice(level), ORDER_SHARES);
+                orders.emplace_back(nextOrderId++, Type::GTC, Side::Ask, askPrice(level), ORDER_SHARES);
+            }
+
+        NullListener noListener;
+        book.addOrders(orders, noListener);
+    }
+
+    static Price bidPrice(size_t level) {return MID_PRICE - HALF_SPREAD - static_cast<Price>(level);}
+    static Price askPrice(size_t level) {return MID_PRICE + HALF_SPREAD + static_cast<Price>(level);}
+
+    size_t randomLevel() {return std::uniform_int_distribution<size_t>(0, nLevels - 1)(gen);}
+
+    size_t randomPosition(size_t level) {return std::uniform_int_distribution<size_t>(0, bidQueues[level].size() - 1)(gen);}
+};
+
+
+// Builds the book of the benchmarks of each size once (the benchmarks are registered size after size)
+class BookCache{
+private:
+    std::unique_ptr<BenchmarkBook> cached;
+
+public:
+    BenchmarkBook& get(size_t nOrders){
+        if (cached == nullptr || cached->nOrders != nOrders){
+            cached.reset();     // Free the previous book first, a 10M orders book takes ~1GB
+            cached = std::make_unique<BenchmarkBook>(nOrders);
+        }
+        return *cached;
+    }
+};
+
+static BookCache bookCache;
+
+
+// Reports the time of the timed batches only, per operation
+class OperationTimer{
+private:
+    benchmark::State& state;
+    double totalNanoseconds = 0.0;
+    double nOperations = 0.0;
+
+public:
+    explicit OperationTimer(benchmark::State& _state): state(_state) {}
+
+    ~OperationTimer(){
+        state.SetItemsProcessed(static_cast<int64_t>(nOperations));
+        state.counters["ns/op"] = (nOperations > 0) ? totalNanoseconds / nOperations : 0.0;
+    }
+
+    template<typename Operations>
+    void time(size_t nBatchOperations, Operations&& operations){
+        const auto start = Clock::now();
+        operations();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        state.SetIterationTime(seconds);
+        totalNanoseconds += 1e9 * seconds;
+        nOperations += nBatchOperations;
+    }
+};
+
+
+void removeFromQueue(std::deque<OrderId>& queue, size_t position){
+    queue.erase(queue.begin() + static_cast<std::ptrdiff_t>(position));
+}
+
+
+void addExistingLevel(benchmark::State& state, size_t nOrders){
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    std::vector<Order> orders(BATCH, Order(0, Type::GTC, Side::Bid, MID_PRICE, 1u));
+    OperationTimer timer(state);
+
+    for (auto _ : state){
+        for (Order& order : orders)
+            order = Order(b.nextOrderId++, Type::GTC, Side::Bid, BenchmarkBook::bidPrice(b.randomLevel()), ORDER_SHARES);
+
+        timer.time(BATCH, [&]{
+            for (const Order& order : orders)
+                b.book.addOrder(order, noListener);
+        });
+
+        for (const Order& order : orders)
+            b.book.cancelOrder(order.getOrderId());
+    }
+}
+
+
+void addNewLevel(benchmark::State& state, size_t nOrders){
+    /* Each order creates a level inside the spread (improving the best bid), the levels are removed by the undo */
+    constexpr size_t NEW_LEVELS = HALF_SPREAD - 1;
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    std::vector<Order> orders(NEW_LEVELS, Order(0, Type::GTC, Side::Bid, MID_PRICE, 1u));
+    OperationTimer timer(state);
+
+    for (auto _ : state){
+        for (size_t i = 0; i < NEW_LEVELS; ++i)
+            orders[i] = Order(b.nextOrderId++, Type::GTC, Side::Bid, static_cast<Price>(MID_PRICE - HALF_SPREAD + 1 + i), ORDER_SHARES);
+
+        timer.time(NEW_LEVELS, [&]{
+            for (const Order& order : orders)
+                b.book.addOrder(order, noListener);
+        });
+
+        for (const Order& order : orders)
+            b.book.cancelOrder(order.getOrderId());
+    }
+}
+
+
+enum class QueuePosition {Head, Middle, Tail};
+
+void cancelAt(benchmark::State& state, size_t nOrders, QueuePosition position){
+    /* The cancelled orders are added back (at the tail of their level) by the undo */
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    std::vector<std::pair<size_t, OrderId>> targets(BATCH);    // [level, order ID]
+    OperationTimer timer(state);
+
+    for (auto _ : state){
+        for (auto& target : targets){
+            size_t level = b.randomLevel();
+            while (b.bidQueues[level].empty())
+                level = b.randomLevel();
+
+            std::deque<OrderId>& queue = b.bidQueues[level];
+            const size_t index = (position == QueuePosition::Head) ? 0 : (position == QueuePosition::Tail) ? queue.size() - 1 : queue.size() / 2;
+            target = {level, queue[index]};
+            removeFromQueue(queue, index);
+        }
+
+        timer.time(BATCH, [&]{
+            for (const auto& target : targets)
+                b.book.cancelOrder(target.second);
+        });
+
+        for (const auto& target : targets){
+            b.book.addOrder(Order(target.second, Type::GTC, Side::Bid, BenchmarkBook::bidPrice(target.first), ORDER_SHARES), noListener);
+            b.bidQueues[target.first].push_back(target.second);
+        }
+    }
+}
+
+
+void amendInPlace(benchmark::State& state, size_t nOrders){
+    /* Size down by one share at the same price, the undo amends the orders back to their size (which moves them to the tail) */
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    std::vector<std::pair<size_t, OrderId>> targets(BATCH);
+    OperationTimer timer(state);
+
+    for (auto _ : state){
+        for (auto& target : targets){
+            const size_t level = b.randomLevel();
+            const size_t index = b.randomPosition(level);
+            target = {level, b.bidQueues[level][index]};
+            removeFromQueue(b.bidQueues[level], index);
+            b.bidQueues[level].push_back(target.second);
+        }
+
+        timer.time(BATCH, [&]{
+            for (const auto& target : targets)
+                b.book.amendOrder(target.second, BenchmarkBook::bidPrice(target.first), ORDER_SHARES - 1, noListener);
+        });
+
+        for (const auto& target : targets)
+            b.book.amendOrder(target.second, BenchmarkBook::bidPrice(target.first), ORDER_SHARES, noListener);
+    }
+}
+
+
+void amendMove(benchmark::State& state, size_t nOrders){
+    /* Move to the back of another existing level, the undo moves the orders back to their level (at its tail) */
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    std::vector<std::pair<size_t, OrderId>> targets(BATCH);
+    std::vector<size_t> destinations(BATCH);
+    OperationTimer timer(state);
+
+    if (b.nLevels < 2){
+        state.SkipWithError("The book has a single level per side");
+        return;
+    }
+
+    for (auto _ : state){
+        for (size_t i = 0; i < BATCH; ++i){
+            const size_t level = b.randomLevel();
+            const size_t index = b.randomPosition(level);
+            targets[i] = {level, b.bidQueues[level][index]};
+            removeFromQueue(b.bidQueues[level], index);
+            b.bidQueues[level].push_back(targets[i].second);
+
+            do
+                destinations[i] = b.randomLevel();
+            while (destinations[i] == level);
+        }
+
+        timer.time(BATCH, [&]{
+            for (size_t i = 0; i < BATCH; ++i)
+                b.book.amendOrder(targets[i].second, BenchmarkBook::bidPrice(destinations[i]), ORDER_SHARES, noListener);
+        });
+
+        for (const auto& target : targets)
+            b.book.amendOrder(target.second, BenchmarkBook::bidPrice(target.first), ORDER_SHARES, noListener);
+    }
+}
+
+
+void match(benchmark::State& state, size_t nOrders, size_t depth){
+    /*  depth ask levels of 4 orders are set up inside the spread (untimed), then a bid order takes all of them: the time
+        covers the fills, the removal of the orders & levels, and the level updates. Nothing is left of the setup   */
+    constexpr size_t ORDERS_PER_LEVEL = 4;
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    std::vector<Order> liquidity;
+    liquidity.reserve(depth * ORDERS_PER_LEVEL);
+    OperationTimer timer(state);
+
+    for (auto _ : state){
+        liquidity.clear();
+        for (size_t level = 0; level < depth; ++level)
+            for (size_t k = 0; k < ORDERS_PER_LEVEL; ++k)
+                liquidity.emplace_back(b.nextOrderId++, Type::GTC, Side::Ask, static_cast<Price>(MID_PRICE - HALF_SPREAD + 1 + level), 10u);
+        b.book.addOrders(liquidity, noListener);
+
+        const Order aggressor(b.nextOrderId++, Type::GTC, Side::Bid, static_cast<Price>(MID_PRICE - HALF_SPREAD + depth),
+                                static_cast<Quantity>(10 * ORDERS_PER_LEVEL * depth));
+
+        timer.time(1, [&]{
+            b.book.addOrder(aggressor, noListener);
+        });
+    }
+    state.counters["levels"] = static_cast<double>(depth);
+}
+
+
+void fokCheck(benchmark::State& state, size_t nOrders, size_t depth){
+    /* A FOK bid up to the price of the depth-th ask level, for one share more than these levels hold: it's rejected */
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    LimitLevelInfos levels;
+    OperationTimer timer(state);
+
+    b.book.getDepth(Side::Ask, depth, levels);
+    uint64_t available = 0;
+    for (const LimitLevelInfo& level : levels)
+        available += level.totalShares;
+
+    const Price price = levels.back().price;
+    std::vector<Order> orders(BATCH, Order(0, Type::FOK, Side::Bid, price, 1u));
+
+    for (auto _ : state){
+        for (Order& order : orders)
+            order = Order(b.nextOrderId++, Type::FOK, Side::Bid, price, static_cast<Quantity>(available + 1));
+
+        timer.time(BATCH, [&]{
+            for (const Order& order : orders)
+                b.book.addOrder(order, noListener);
+        });
+    }
+    state.counters["levels"] = static_cast<double>(levels.size());
+    state.counters["indexed"] = b.book.hasDepthIndex(Side::Ask);   // 0: the checks walked the levels (see CumulativeDepth)
+}
+
+
+void gfdSweep(benchmark::State& state, size_t nOrders){
+    /*  GFD bids (10% of the book) are added at random levels, then the clock moves past the close: the time covers
+        expireOrders until nothing is due, per expired order. The clock goes back to the session for the next iteration   */
+    BenchmarkBook& b = bookCache.get(nOrders);
+    NullListener noListener;
+    const size_t nGFDOrders = std::max<size_t>(nOrders / 10, 1);
+    const auto afterClose = OrderBook::nextMarketClose(b.sessionTime) + std::chrono::seconds(1);
+    std::vector<Order> orders;
+    orders.reserve(nGFDOrders);
+    OperationTimer timer(state);
+
+    for (auto _ : state){
+        b.clock.set(b.sessionTime);
+        orders.clear();
+        for (size_t i = 0; i < nGFDOrders; ++i)
+            orders.emplace_back(b.nextOrderId++, Type::GFD, Side::Bid, BenchmarkBook::bidPrice(b.randomLevel()), ORDER_SHARES);
+        b.book.addOrders(orders, noListener);
+
+        b.clock.set(afterClose);
+        timer.time(nGFDOrders, [&]{
+            while (b.book.expireOrders() > 0);
+        });
+    }
+    b.clock.set(b.sessionTime);
+}
+
+
+std::vector<size_t> parseSizes(int& argc, char* argv[]){
+    /* --sizes=a,b,... is removed from the arguments, the others are Google Benchmark's */
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000, 10000000};
+    const std::string flag = "--sizes=";
+
+    int kept = 1;
+    for (int i = 1; i < argc; ++i){
+        const std::string argument = argv[i];
+        if (argument.compare(0, flag.size(), flag) == 0){
+            sizes.clear();
+            std::istringstream list(argument.substr(flag.size()));
+            for (std::string size; std::getline(list, size, ',');)
+                sizes.push_back(std::stoull(size));
+        }
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    return sizes;
+}
+
+
+int main(int argc, char* argv[]){
+    const std::vector<size_t> sizes = parseSizes(argc, argv);
+
+    using Case = std::function<void(benchmark::State&)>;
+    auto add = [](const std::string& name, size_t nOrders, Case function){
+        benchmark::RegisterBenchmark((name + "/" + std::to_string(nOrders)).c_str(), function)
+            ->UseManualTime()->Unit(benchmark::kNanosecond);
+    };
+
+    // Size after size, thus each book is built once
+    for (size_t nOrders : sizes){
+        const size_t nLevels = std::clamp<size_t>(nOrders / 8, 1, MAX_LEVELS);
+
+        add("AddExistingLevel", nOrders, [=](benchmark::State& state){addExistingLevel(state, nOrders);});
+        add("AddNewLevel", nOrders, [=](benchmark::State& state){addNewLevel(state, nOrders);});
+        add("CancelHead", nOrders, [=](benchmark::State& state){cancelAt(state, nOrders, QueuePosition::Head);});
+        add("CancelMiddle", nOrders, [=](benchmark::State& state){cancelAt(state, nOrders, QueuePosition::Middle);});
+        add("CancelTail", nOrders, [=](benchmark::State& state){cancelAt(state, nOrders, QueuePosition::Tail);});
+        add("AmendInPlace", nOrders, [=](benchmark::State& state){amendInPlace(state, nOrders);});
+        add("AmendMove", nOrders, [=](benchmark::State& state){amendMove(state, nOrders);});
+
+        for (size_t depth : {1, 2, 4, 8, 16, 32, 63})
+            add("Match/" + std::to_string(depth), nOrders, [=](benchmark::State& state){match(state, nOrders, depth);});
+
+        for (size_t depth : {1, 10, 100, 1000})
+            if (depth <= nLevels)
+                add("FOKCheck/" + std::to_string(depth), nOrders, [=](benchmark::State& state){fokCheck(state, nOrders, depth);});
+
+        add("GFDSweep", nOrders, [=](benchmark::State& state){gfdSweep(state, nOrders);});
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    std::cout << "Price levels backend: " << PRICE_LEVELS_BACKEND << std::endl;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+}
@@ -0,0 +1,68 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+#include "BookFile.cpp"
+#include "Journal.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:replay_journal.exe replay_journal.cpp
+//  execute: ./replay_journal.exe <journal.bin> [--snapshot book.bin]
+
+/*  Recovery: rebuilds the order book of a journal (see Journal.h) by replaying its commands into an empty book, at the
+    time each one was accepted. The trades are the ones of the original run. With --snapshot the rebuilt book is saved,
+    thus a live book can be restarted from it with loadSnapshot (and continue journaling to the same journal).   */
+
+using Clock = std::chrono::steady_clock;
+
+
+int main(int argc, char* argv[]){
+    if (argc < 2){
+        std::cerr << "Usage: " << argv[0] << " <journal.bin> [--snapshot book.bin]" << '\n';
+        return 1;
+    }
+
+    const std::string filename = argv[1];
+    std::string snapshotFilename;
+
+    try{
+        for (int i = 2; i < argc; ++i){
+            std::string argument = argv[i];
+            if (argument == "--snapshot" && i + 1 < argc)
+                snapshotFilename = argv[++i];
+            else
+                throw std::invalid_argument("Unknown argument " + argument);
+        }
+
+        ManualWallClock clock;
+        OrderBook orderBook(0, LogVerbosity::Silent, false, clock);
+        TradeCounter tradeCounter;
+
+        const auto start = Clock::now();
+        const JournalReplayResult result = replayJournal(filename, orderBook, clock, tradeCounter);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << "Replayed " << result.nRecords << " commands from " << filename << '\n'
+                  << "    Last sequence:    " << result.lastSequence << (result.truncated ? " (followed by a torn or corrupted record, ignored with the rest of the file)" : "") << '\n'
+                  << "    Trades:           " << tradeCounter.nTrades << '\n'
+                  << "    Resting orders:   " << orderBook.getNumberOfOrders() << '\n'
+                  << "    Time:             " << std::fixed << std::setprecision(3) << seconds << " s" << '\n'
+                  << "    Commands/second:  " << std::setprecision(0) << result.nRecords / seconds << std::endl;
+
+        if (!snapshotFilename.empty()){
+            orderBook.saveSnapshot(snapshotFilename);
+            std::cout << "Book saved to " << snapshotFilename << std::endl;
+        }
+    }
+    catch (const std::exception& e){
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+#include "ReplaySource.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:replay_orders.exe replay_orders.cpp
+//  execute: ./replay_orders.exe <orders.bin | orders.jsonl> [--paced [speed]] [--chunk records] [--batch orders]
+
+/*  Streams an order file of any size into an order book: a read-ahead thread reads the next chunks of the file
+    while the current one is being matched. Binary order files (see OrderFile.h) and JSON lines files are supported.
+    With --paced, orders are released at their recorded timestamps (speed > 1 replays faster than real time).   */
+
+
+int main(int argc, char* argv[]){
+    if (argc < 2){
+        std::cerr << "Usage: " << argv[0] << " <orders.bin | orders.jsonl> [--paced [speed]] [--chunk records] [--batch orders]" << '\n';
+        return 1;
+    }
+
+    const std::string filename = argv[1];
+    ReplayPacing pacing = ReplayPacing::AsFastAsPossible;
+    double speed = 1.0;
+    size_t chunkSize = 4096;
+    size_t batchSize = 4096;
+
+    try{
+        for (int i = 2; i < argc; ++i){
+            std::string argument = argv[i];
+            if (argument == "--paced"){
+                pacing = ReplayPacing::OriginalTimestamps;
+                if (i + 1 < argc && argv[i + 1][0] != '-')
+                    speed = std::stod(argv[++i]);
+            }
+            else if (argument == "--chunk" && i + 1 < argc)
+                chunkSize = std::stoull(argv[++i]);
+            else if (argument == "--batch" && i + 1 < argc)
+                batchSize = std::stoull(argv[++i]);
+            else
+                throw std::invalid_argument("Unknown argument " + argument);
+        }
+
+        OrderBook orderBook(0, LogVerbosity::Silent, false);
+        ReplaySource source(ReplaySource::openReader(filename), pacing, speed, chunkSize);
+        ReplayResult result = source.replay(orderBook, batchSize);
+
+        std::cout << "Replayed " << result.nReplayed << " orders from " << filename
+                  << ((pacing == ReplayPacing::OriginalTimestamps) ? " (paced)" : "") << '\n'
+                  << "    Invalid records:  " << result.nInvalid << '\n'
+                  << "    Trades:           " << result.nTrades << '\n'
+                  << "    Resting orders:   " << orderBook.getNumberOfOrders() << '\n'
+                  << "    Time:             " << std::fixed << std::setprecision(3) << result.seconds << " s" << '\n'
+                  << "    Orders/second:    " << std::setprecision(0) << result.nReplayed / result.seconds << std::endl;
+    }
+    catch (const std::exception& e){
+        std::cerr << "Error: " << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <atomic>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "Sequencer.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:sequencer_benchmark.exe sequencer_benchmark.cpp
+//  execute: ./sequencer_benchmark.exe [number of commands per producer]
+
+/*  Compares the two ways of sharing one order book between 1 to 16 order-entry (producer) threads:
+        - mutex: every producer calls addOrder/cancelOrder/amendOrder directly, serializing on the book's mutex.
+          Latency = duration of the call (including the wait for the lock).
+        - sequencer: producers push commands into the Sequencer's MPSC queue and poll their result queue, keeping up to
+          WINDOW commands in flight. Latency = time from submission until the final (Accepted/Rejected) report.
+    Throughput is the total number of commands over the wall time of the run.   */
+
+constexpr size_t WINDOW = 32;   // Maximum number of commands in flight per producer in sequencer mode
+
+
+std::vector<OrderCommand> generateCommands(size_t producer, size_t nCommands, uint32_t seed = 42){
+    /* Random adds around a common mid price (thus producers trade with each other), cancellations and amendments.
+       Each producer uses its own range of order IDs and only cancels/amends its own orders. */
+    std::mt19937 gen(seed + static_cast<uint32_t>(producer));
+    std::uniform_real_distribution<> actionDist(0.0, 1.0);
+    std::uniform_int_distribution<int> offsetDist(-50, 50);
+    std::uniform_int_distribution<uint32_t> sharesDist(1, 500);
+
+    const Price midPrice = toTicks(100.0);
+    OrderId nextOrderId = static_cast<OrderId>(producer << 24) + 1;
+    std::vector<OrderId> addedIds;
+
+    std::vector<OrderCommand> commands;
+    commands.reserve(nCommands);
+
+    while (commands.size() < nCommands){
+        const double action = actionDist(gen);
+
+        if (addedIds.empty() || action < 0.6){
+            const Side side = (gen() % 2) ? Side::Bid : Side::Ask;
+            const Price price = midPrice + offsetDist(gen) + (side == Side::Bid ? -10 : 10);
+            commands.push_back(OrderCommand::add(Order(nextOrderId, Type::GTC, side, price, sharesDist(gen))));
+            addedIds.push_back(nextOrderId++);
+        }
+        else{
+            const size_t position = gen() % addedIds.size();
+            const OrderId orderId = addedIds[position];
+
+            if (action < 0.8){
+                commands.push_back(OrderCommand::cancel(0, orderId));
+                addedIds[position] = addedIds.back();
+                addedIds.pop_back();
+            }
+            else
+                commands.push_back(OrderCommand::amend(0, orderId, midPrice + offsetDist(gen), sharesDist(gen)));
+        }
+    }
+
+    return commands;
+}
+
+
+struct RunResult{
+    double seconds;
+    LatencyHistogram latencies;
+};
+
+
+template<typename ProducerFunction>
+RunResult runProducers(size_t nProducers, ProducerFunction&& producerFunction){
+    /* Start nProducers threads at the same time, each calling producerFunction(producer, latencies) */
+    std::vector<LatencyHistogram> latencies(nProducers);
+    std::vector<std::thread> producers;
+    std::atomic<bool> go{false};
+
+    for (size_t producer = 0; producer < nProducers; ++producer)
+        producers.emplace_back([&, producer] {
+                                                while (!go.load(std::memory_order_acquire))
+                                                    std::this_thread::yield();
+                                                producerFunction(producer, latencies[producer]);
+                                            }
+                                );
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& producer : producers)
+        producer.join();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    RunResult result{elapsed.count(), LatencyHistogram{}};
+    for (const auto& producerLatencies : latencies)
+        result.latencies.merge(producerLatencies);
+    return result;
+}
+
+
+RunResult runMutex(const std::vector<std::vector<OrderCommand>>& commands, size_t expectedOrders){
+    OrderBook book(expectedOrders, LogVerbosity::Silent, false);
+
+    return runProducers(commands.size(), [&](size_t producer, LatencyHistogram& latencies){
+        TradeCounter tradeCounter;  // The producer gets its executions synchronously
+
+        for (const auto& command : commands[producer]){
+            auto start = std::chrono::steady_clock::now();
+            try{
+                switch (command.command){
+                    case CommandType::Add: book.addOrder(command.toOrder(), tradeCounter); break;
+                    case CommandType::Cancel: book.cancelOrder(command.orderId); break;
+                    case CommandType::Amend: book.amendOrder(command.orderId, command.price, command.shares, tradeCounter); break;
+                }
+            }
+            catch (const std::exception&) {}
+            latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+    });
+}
+
+
+RunResult runSequencer(const std::vector<std::vector<OrderCommand>>& commands, size_t expectedOrders){
+    Sequencer sequencer(commands.size(), 1 << 16, 1 << 16, expectedOrders);
+
+    return runProducers(commands.size(), [&](size_t producer, LatencyHistogram& latencies){
+        const ClientId client = sequencer.registerClient();
+        const auto& producerCommands = commands[producer];
+        std::vector<std::chrono::steady_clock::time_point> submitTimes(producerCommands.size());
+
+        size_t nSubmitted = 0, nDone = 0;
+        ExecutionReport executionReport;
+
+        while (nDone < producerCommands.size()){
+            if (nSubmitted < producerCommands.size() && nSubmitted - nDone < WINDOW){
+                submitTimes[nSubmitted] = std::chrono::steady_clock::now();
+                if (sequencer.trySubmit(client, nSubmitted, producerCommands[nSubmitted]))
+                    ++nSubmitted;
+            }
+
+            while (sequencer.tryPoll(client, executionReport))
+                if (executionReport.type != ReportType::Trade){  // Final report of the command
+                    latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now() - submitTimes[executionReport.requestId]).count());
+                    ++nDone;
+                }
+
+            if (nSubmitted - nDone >= WINDOW)
+                std::this_thread::yield();
+        }
+    });
+}
+
+
+int main(int argc, char* argv[]){
+    size_t nCommandsPerProducer = (argc > 1) ? std::stoul(argv[1]) : 100000;
+
+    std::cout << std::setw(10) << "Producers" << std::setw(11) << "Mode" << std::setw(16) << "Commands/s"
+              << std::setw(12) << "p50 (μs)" << std::setw(12) << "p99 (μs)" << std::setw(14) << "p99.9 (μs)" << std::setw(12) << "max (μs)" << std::endl;
+
+    auto printResult = [](size_t nProducers, const char* mode, size_t nCommands, const RunResult& result){
+        std::cout << std::setw(10) << nProducers << std::setw(11) << mode
+                  << std::setw(16) << std::fixed << std::setprecision(0) << nCommands / result.seconds << std::setprecision(2)
+                  << std::setw(12) << result.latencies.percentile(50.0) / 1e3
+                  << std::setw(12) << result.latencies.percentile(99.0) / 1e3
+                  << std::setw(14) << result.latencies.percentile(99.9) / 1e3
+                  << std::setw(12) << result.latencies.max() / 1e3 << std::endl;
+    };
+
+    for (size_t nProducers = 1; nProducers <= 16; nProducers *= 2){
+        std::vector<std::vector<OrderCommand>> commands;
+        for (size_t producer = 0; producer < nProducers; ++producer)
+            commands.push_back(generateCommands(producer, nCommandsPerProducer));
+
+        const size_t nCommands = nProducers * nCommandsPerProducer;
+        printResult(nProducers, "mutex", nCommands, runMutex(commands, nCommands / 2));
+        printResult(nProducers, "sequencer", nCommands, runSequencer(commands, nCommands / 2));
+    }
+
+    if (std::thread::hardware_concurrency() < 17)
+        std::cout << "\nNote: only " << std::thread::hardware_concurrency() << " hardware threads, runs with more threads are oversubscribed" << std::endl;
+}
@@ -0,0 +1,99 @@
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <nlohmann/json.hpp>
+
+#include "Order.cpp"
+#include "EventLog.cpp"
+#include "OrderBook.cpp"
+#include "OrderFile.cpp"
+#include "BookFile.cpp"
+
+//  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /O2 /DORDERBOOK_NO_INSTRUMENTATION /Fe:snapshot_benchmark.exe snapshot_benchmark.cpp
+//  execute: ./snapshot_benchmark.exe [number of resting orders...]     (default: 1000000 10000000)
+
+/*  Time to rebuild a book of N resting orders after a restart: re-feeding the orders through addOrders (the previous way)
+    vs loadSnapshot of a snapshot saved by saveSnapshot. The restored book is compared with the original one: same levels,
+    and the same orders in the same time priority (the snapshot of the restored book must be identical byte for byte).   */
+
+using Clock = std::chrono::steady_clock;
+
+
+std::vector<Order> restingOrders(size_t nOrders, uint32_t seed = 42){
+    /* Bids below 30.00 and asks above it (nothing trades), a mix of order types and some partially filled orders */
+    std::mt19937 gen(seed);
+    std::exponential_distribution<> distanceDist(1.0);
+    std::uniform_int_distribution<Quantity> sharesDist(1, 100);
+    std::uniform_int_distribution<int> typeDist(0, 9);
+
+    const ExpiryTime expiry = toExpiryTime(std::chrono::system_clock::now()) + 3600;
+
+    std::vector<Order> orders;
+    orders.reserve(nOrders);
+    for (size_t i = 1; i <= nOrders; ++i){
+        const Side side = (i % 2) ? Side::Bid : Side::Ask;
+        const Price distance = 1 + static_cast<Price>(distanceDist(gen) * 100);
+        const Price price = toTicks(30.0) + ((side == Side::Bid) ? -distance : distance);
+        const int type = typeDist(gen);
+
+        orders.emplace_back(static_cast<OrderId>(i), (type == 0) ? Type::GFD : (type == 1) ? Type::GTT : Type::GTC, side, price, sharesDist(gen));
+        if (type == 1)
+            orders.back().setExpiry(expiry + static_cast<ExpiryTime>(i % 600));
+        if (type == 2 && orders.back().getOrderShares() > 1)
+            orders.back().fillOrder(1);
+    }
+    return orders;
+}
+
+
+int main(int argc, char* argv[]){
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::stoull(argv[i]));
+    if (sizes.empty())
+        sizes = {1000000, 10000000};
+
+    const std::string filename = "book_snapshot.bin";
+    const std::string copyFilename = "book_snapshot_copy.bin";
+
+    std::cout << "Price levels backend: " << PRICE_LEVELS_BACKEND << std::endl;
+    std::cout << std::setw(10) << "Orders" << std::setw(16) << "addOrders (ms)" << std::setw(12) << "Save (ms)"
+              << std::setw(12) << "Load (ms)" << std::setw(14) << "Speedup" << std::setw(12) << "File (MB)" << std::setw(10) << "Identical" << std::endl;
+
+    for (size_t nOrders : sizes){
+        const std::vector<Order> orders = restingOrders(nOrders);
+
+        OrderBook original(nOrders, LogVerbosity::Silent, false);
+        NullListener noListener;
+
+        auto start = Clock::now();
+        original.addOrders(orders, noListener);
+        const double feedTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        original.saveSnapshot(filename);
+        const double saveTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        OrderBook restored(0, LogVerbosity::Silent, false);
+
+        start = Clock::now();
+        restored.loadSnapshot(filename);
+        const double loadTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        // Saving the restored book must give the same file: same levels, orders, priority, fills & expiries
+        restored.saveSnapshot(copyFilename);
+        const bool identical = sameFileContents(filename, copyFilename) && (restored.getNumberOfOrders() == nOrders);
+        const double fileSize = MappedFile(filename).size() / 1e6;
+
+        std::cout << std::setw(10) << nOrders << std::fixed << std::setprecision(1) << std::setw(16) << feedTime
+                  << std::setw(12) << saveTime << std::setw(12) << loadTime << std::setw(13) << feedTime / loadTime << "x"
+                  << std::setw(12) << fileSize << std::setw(10) << (identical ? "yes" : "NO") << std::endl;
+    }
+
+    std::remove(filename.c_str());
+    std::remove(copyFilename.c_str());
+}
@@ -5,12 +5,18 @@
 #include <chrono>
 #include <numeric>
 #include <cassert>
+#include <map>
 #include <nlohmann/json.hpp>
 
 #include "Order.cpp"
+#include "EventLog.cpp"
 #include "OrderBook.cpp"
+#include "OrderFile.cpp"
+#include "Workload.h"
 
 //  compile: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /Fe:test.exe test.cpp
+//  compile with the price ladder backend: cl.exe /I "C:/Users/oussa/Desktop/vcpkg/installed/x64-windows/include" /EHsc /DORDERBOOK_LADDER /Fe:test.exe test.cpp
+//  compile without latency instrumentation (bare engine): add /DORDERBOOK_NO_INSTRUMENTATION, or /DORDERBOOK_CHRONO_TIMESTAMPS to time with steady_clock instead of the TSC
 //  execute: ./out:test.exe
 
 using json = nlohmann::json;
@@ -19,12 +25,29 @@ using json = nlohmann::json;
 static std::unordered_map<std::string, Type> _map_types = {{"GTC", Type::GTC}, {"FAK", Type::FAK}, {"FOK", Type::FOK}, {"GFD", Type::GFD}, {"M", Type::M}};
 static std::unordered_map<std::string, Side> _map_sides = {{"Bid", Side::Bid}, {"Ask", Side::Ask}};
 
+// Silent by default so that the benchmark measures matching and not the terminal (LogVerbosity::Orders to see every event)
+static LogVerbosity logVerbosity = LogVerbosity::Silent;
+
 auto populateOrderBook(const std::string& inputFilename, OrderBook& orderBook) {
     /*
         Given a .json file where each element is an object:
         {"type": "GTC", "side": "Bid", "price": 32.5, "shares": 100} 
-        This function populates the given orderBook with the orders from the JSON file.
+        This function populates the given orderBook with the orders from the JSON file, as a single batch.
+        Binary order files (.bin, see convert_orders.cpp) are memory mapped and loaded without parsing.
     */
+    if (inputFilename.size() > 4 && inputFilename.compare(inputFilename.size() - 4, 4, ".bin") == 0){
+        try{
+            OrderFileLoadResult result = loadOrderFile(inputFilename, orderBook);
+            if (result.nInvalid > 0)
+                std::cerr << "Warning: " << result.nInvalid << " invalid orders were skipped.\n";
+            return static_cast<int>(result.maxOrderId) + 1;
+        }
+        catch (const std::runtime_error& e){
+            std::cerr << "Error: " << e.what() << '\n';
+            return -1;
+        }
+    }
+
 
     std::ifstream inputFile(inputFilename);
     if (!inputFile.is_open()){
@@ -42,17 +65,17 @@ auto populateOrderBook(const std::string& inputFilename, OrderBook& orderBook) {
     }
 
     int orderId = 1;
+    std::vector<Order> initialOrders;
+    initialOrders.reserve(inputFileOrders.size());
 
     for (const auto& orderEntry : inputFileOrders){
         try{
             std::string typeStr = orderEntry.at("type");
             std::string sideStr = orderEntry.at("side");
-            double price = orderEntry.at("price");
+            Price price = toTicks(orderEntry.at("price").get<double>());
             int shares = orderEntry.at("shares");
 
-            auto order = std::make_shared<Order>(orderId, _map_types[typeStr], _map_sides[sideStr], price, shares);
-
-            orderBook.addOrder(order);
+            initialOrders.emplace_back(orderId, _map_types[typeStr], _map_sides[sideStr], price, shares);
             ++orderId;
         } 
         catch (const json::out_of_range& e){
@@ -64,23 +87,28 @@ auto populateOrderBook(const std::string& inputFilename, OrderBook& orderBook) {
     }
 
     inputFile.close();
+
+    // Load all the orders at once: a single lock, and matching only where an order crosses the book
+    NullListener noListener;
+    orderBook.addOrders(initialOrders, noListener);
+
     return orderId; // Id of the next order in case we add any
 }
 
 
-void updateOrderBook(OrderBook& orderBook, int nUpdates, uint32_t newOrderId,
+void updateOrderBook(OrderBook& orderBook, int nUpdates, uint32_t newOrderId, uint32_t seed,
                     double addProb = 0.3, double cancelProb = 0.1, double amendProb = 0.6, 
                     int meanShares = 50, double meanPrice = 30.00){
     /*
         Given an order book (non-empty), this method updates this order book by adding new orders, amending or cancelling existing orders
         given the input parameters.
         At the same time, the latency of each type of orders is being computed and reported to evaluate the performance of the implementation.
+        Every random draw comes from a generator of the given seed, thus two runs with the same seed send the same requests.
     */
     orderBook.clearLatencies();
 
-    // Assuming mean_shares and mean_price are defined elsewhere
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> actionDist(0.0, 1.0);
 
     // Normal distributions for shares and price
     std::normal_distribution<> shareDist(meanShares, 50); // Adjust standard deviation as needed
@@ -93,58 +121,154 @@ void updateOrderBook(OrderBook& orderBook, int nUpdates, uint32_t newOrderId,
     Type types[] = {Type::GTC, Type::FAK, Type::FOK, Type::GFD, Type::M};
     Side sides[] = {Side::Bid, Side::Ask};
 
+    NullListener noListener;    // The trades aren't used, thus they aren't collected
+
+    // Targets of the amends & cancels, drawn in O(1) among the orders added so far: the ones no longer in the book are dropped when drawn
+    LiveOrders targets;
+    targets.reserve(newOrderId + nUpdates);
+    for (OrderId orderId = 1; orderId < newOrderId; ++orderId)
+        targets.insert({orderId, 0, 0, Side::Bid});
+
+    auto drawTarget = [&]{
+        while (!targets.empty()){
+            const OrderId orderId = targets.sample(gen).orderId;
+            if (orderBook.findOrder(orderId) != nullptr)
+                return orderId;
+            targets.erase(orderId);
+        }
+        return OrderId{0};
+    };
+
     for (int i = 0; i < nUpdates; ++i){
         // Randomly choose action based on these probabilities
-        double actionDecision = static_cast<double>(rand()) / RAND_MAX;
+        double actionDecision = actionDist(gen);
 
-        if (actionDecision < addProb){  // Add order
-            std::cout << "Add a new order" << std::endl;
+        if (actionDecision < addProb || orderBook.getNumberOfOrders() == 0){  // Add order (also when there is nothing left to amend or cancel)
             newOrderId += 1;    
             Type type = types[typeDist(gen)];
             Side side = sides[sideDist(gen)];
-            double newPrice = std::max(1.0, priceDist(gen)); // Ensure price is positive
+            Price newPrice = toTicks(std::max(1.0, priceDist(gen))); // Ensure price is positive
             int newShares = std::max(5, static_cast<int>(shareDist(gen))); // Ensure shares are positive
 
-            auto newOrder = std::make_shared<Order> (newOrderId, type, side, newPrice, newShares);
+            Order newOrder(newOrderId, type, side, newPrice, newShares);
 
-            orderBook.addOrder(newOrder);
+            orderBook.addOrder(newOrder, noListener);
+            targets.insert({newOrderId, newPrice, static_cast<Quantity>(newShares), side});
         }
         else if (actionDecision < addProb + amendProb){ // Amend order
-            std::cout << "Modify existing order" << std::endl;
-            uint32_t orderId = orderBook.getRandomOrderId();
-            auto orderPtr = orderBook.getOrderPtr(orderId);
-            double newPrice = std::max(1.0, priceDist(gen)); // Ensure price is positive
+            uint32_t orderId = drawTarget();
+            Price newPrice = toTicks(std::max(1.0, priceDist(gen))); // Ensure price is positive
             int newShares = std::max(5, static_cast<int>(shareDist(gen))); // Ensure shares are positive
             
-            (void) orderBook.amendOrder(orderPtr, newPrice, newShares);
+            orderBook.amendOrder(orderId, newPrice, newShares, noListener);
         }
         else { // Cancel order
-            std::cout << "Cancel existing order" << std::endl;
-            uint32_t orderId = orderBook.getRandomOrderId();
+            uint32_t orderId = drawTarget();
 
             orderBook.cancelOrder(orderId);
+            targets.erase(orderId);
         }    
     }
 }
 
 
+json loadLatencyStats(const std::string& statsFilename){
+    /* Load a previously written stats file (e.g. from a run before a change), or an empty json if there is none */
+    std::ifstream statsFile(statsFilename);
+    if (!statsFile.is_open())
+        return json();
+
+    try {
+        return json::parse(statsFile);
+    }
+    catch (const json::parse_error& e){
+        std::cerr << "Warning: Failed to parse baseline stats file " << statsFilename << ". " << e.what() << '\n';
+        return json();
+    }
+}
+
+
+void reportLatencyDelta(const json& baselineStats, const json& newStats){
+    /*
+        Print, for every (operation, order type, limit level status) bucket present in both stats files, the mean latency
+        before and after as well as the relative change. Used to measure the impact of a change to the order book.
+    */
+    if (baselineStats.is_null()){
+        std::cout << "No baseline latency statistics found, skipping latency delta report." << std::endl;
+        return;
+    }
+
+    const std::string meanKey = "mean_latency (μs)";
+
+    auto bucketName = [](const std::string& operation, const json& entry){
+        std::string name = operation;
+        if (entry.contains("order_type"))
+            name += " " + entry["order_type"].get<std::string>();
+        if (entry.contains("amend_path"))
+            name += " " + entry["amend_path"].get<std::string>();
+        if (entry.contains("limit_level_status"))
+            name += " " + entry["limit_level_status"].get<std::string>();
+        return name;
+    };
+
+    // Flatten both files into bucket name -> mean latency
+    auto collectMeans = [&](const json& stats){
+        std::map<std::string, double> means;
+        for (const auto& item : stats.items()){
+            if (item.value().is_array()){  // Add / Amend / Cancel
+                for (const auto& entry : item.value())
+                    if (entry.contains(meanKey))
+                        means[bucketName(item.key(), entry)] = entry[meanKey];
+            }
+            else if (item.value().contains(meanKey))  // Match
+                means[bucketName(item.key(), item.value())] = item.value()[meanKey];
+        }
+        return means;
+    };
+
+    auto baselineMeans = collectMeans(baselineStats);
+    auto newMeans = collectMeans(newStats);
+
+    std::cout << "\nMean latency delta (baseline -> current, μs):" << std::endl;
+    for (const auto& item : newMeans){
+        auto it = baselineMeans.find(item.first);
+        if (it == baselineMeans.end())
+            continue;
+
+        double change = (it->second != 0.0) ? 100.0 * (item.second - it->second) / it->second : 0.0;
+        std::cout << "  " << item.first << ": " << it->second << " -> " << item.second
+                  << " (" << std::showpos << change << std::noshowpos << "%)" << std::endl;
+    }
+}
+
+
 int main(){
-    std::mt19937 rng(42);  // 42 is the seed
+    const uint32_t seed = 42;   // Seed of the updates, thus runs can be reproduced & compared
 
-    std::string ordersFilename = "orders.json";
+    std::string ordersFilename = "orders.json";    // or a binary order file, e.g. orders.bin from convert_orders.cpp
     std::string resultsFilename = "stats.json";
     size_t nUpdates = 100000;
+    size_t expectedOrders = 1 << 16;    // Pre-sizing hint for the order book
     
-    OrderBook orderBook;
+    json baselineStats = loadLatencyStats(resultsFilename); // Stats of the previous run, used to report the latency delta
+
+    OrderBook orderBook(expectedOrders, logVerbosity);
 
+    auto replayStart = std::chrono::high_resolution_clock::now();
     size_t nextOrderId = populateOrderBook(ordersFilename, orderBook);
+    std::chrono::duration<double, std::milli> replayTime = std::chrono::high_resolution_clock::now() - replayStart;
+
     std::cout << "\n ******************** \n Order Book initialized and populated with " 
           << (nextOrderId - 1) 
-          << " orders \n ********************  \n" << std::endl;
+          << " orders in " << replayTime.count() << " ms (" << PRICE_LEVELS_BACKEND << " price levels backend, "
+          << Timestamp::source() << " timestamps)"
+          << " \n ********************  \n" << std::endl;
     //orderBook.printOrderBook();
 
-    updateOrderBook(orderBook, nUpdates, nextOrderId);
+    updateOrderBook(orderBook, nUpdates, nextOrderId, seed);
 
     orderBook.writeLatencyStatsToFile(resultsFilename, nUpdates);
+
+    reportLatencyDelta(baselineStats, loadLatencyStats(resultsFilename));
 }
 